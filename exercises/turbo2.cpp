@@ -6,36 +6,9 @@
 #include <iostream>
 #include <vector>
 
-using namespace std;
-
-class FenwickTree
-{
-
-public:
-
-    int n;
-    std::vector<int> arr;
-
-    FenwickTree(int n): n(n), arr(n+1, 0) {}
-
-    void update(int i, int val)
-    {
-        for (; i <= this->n; i += i & (-i)) {
-            this->arr[i] += val;
-        }
-    }
-
-    int query(int i)
-    {
-        int res = 0;
-        for(; i > 0; i -= i & (-i)) {
-            res += this->arr[i];
-        }
+#include "../util/fenwick.cpp"
 
-        return res;
-    }
-
-};
+using namespace std;
 
 int N;
 int lookup [100002] = {0};
@@ -47,13 +20,13 @@ int main()
 
     cin >> N;
 
-    FenwickTree ft(N);
+    // Every position starts out occupied
+    FenwickTree<int> ft(vector<int>(N, 1));
 
     int val;
     for (int i = 1; i <= N; ++i) {
         cin >> val;
         lookup[val] = i;
-        ft.update(i, 1);
     }
 
 
@@ -64,19 +37,19 @@ int main()
             int index = lookup[num];
 
             // cout << "num = " << num << " index = " << index << '\n';
-            // cout << "ft.query(index) = " << ft.query(index) << '\n';
+            // cout << "ft.sum(index) = " << ft.sum(index) << '\n';
 
-            cout << ft.query(index) - 1 << '\n';
-            ft.update(index, -1);
+            cout << ft.sum(index) - 1 << '\n';
+            ft.add(index - 1, -1);
         } else {
             int num = N - (i/2) + 1;
             int index = lookup[num];
 
             // cout << "num = " << num << " index = " << index << '\n';
-            // cout << "ft.query(N) = " << ft.query(N) << " ft.query(index) = " << ft.query(index) << '\n';
+            // cout << "ft.sum(N) = " << ft.sum(N) << " ft.sum(index) = " << ft.sum(index) << '\n';
 
-            cout << ft.query(N) - ft.query(index) << '\n';
-            ft.update(index, -1);
+            cout << ft.sum(N) - ft.sum(index) << '\n';
+            ft.add(index - 1, -1);
         }
     }
 
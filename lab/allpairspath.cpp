@@ -2,6 +2,17 @@
 #include <vector>
 #include <algorithm>
 #include <limits.h>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <immintrin.h>
+#include <queue>
+#include <mutex>
+#include <functional>
+#include "../util/bellmanford.cpp"
+#include "../util/parallel.cpp"
 
 /**
  * @author Oskar Arensmeier
@@ -53,6 +64,7 @@
  */
 
 using namespace std;
+using ll = long long;
 
 const int INF = numeric_limits<int>::max();
 
@@ -138,11 +150,898 @@ public:
     }
 };
 
-int main()
+/**
+ * Blocked (tiled) Floyd-Warshall
+ * reference: G. Venkataraman et al., "A Blocked All-Pairs Shortest-Paths
+ * Algorithm", 2003
+ *
+ * Same recurrence as FloydWarshall, but over one contiguous row-major
+ * matrix split into B x B tiles. For every block of B values of k:
+ *
+ * 1. The diagonal tile (kb, kb) runs plain Floyd-Warshall on itself.
+ * 2. Tiles in row kb and column kb are updated using the diagonal tile.
+ * 3. All other tiles (i, j) are updated with tiles (i, kb) and (kb, j).
+ *
+ * Tiles within phase 2 and within phase 3 are independent, so they are
+ * spread over threads. Each tile update is a min-plus kernel
+ * C[i][j] = min(C[i][j], A[i][k] + B[k][j]) with no branch in the inner
+ * loop: unreachable entries (INF) are masked out of the sum instead of
+ * tested. With AVX2 (checked at runtime) eight entries are handled per
+ * instruction.
+ *
+ * Distances are 32-bit and clamped at -LIMIT, which only happens behind
+ * negative cycles (real distances must lie within (-LIMIT, LIMIT)).
+ *
+ * Negative cycles are marked in one extra pass instead of a second O(n^3)
+ * loop: negative nodes (d[k][k] < 0) are grouped by strongly connected
+ * component, which share reachability, and for each row i the reachability
+ * bitsets of the components i reaches are or-ed together. Entries whose bit
+ * is set become -INF. O(n^2 * c / 64) for c such components.
+ *
+ * Time complexity: O(n^3 / (threads * lanes))
+ * Space complexity: O(n^2)
+ */
+class BlockedFloydWarshall
+{
+public:
+    /**
+     * Tile side
+     */
+    static constexpr int B = 64;
+
+    /**
+     * Distances must lie strictly within (-LIMIT, LIMIT)
+     */
+    static constexpr int LIMIT = 1 << 30;
+
+    /**
+     * Number nodes
+     */
+    int n;
+
+    /**
+     * Padded side, multiple of B
+     */
+    int N;
+
+    /**
+     * Row-major N x N distance matrix
+     */
+    vector<int> dist;
+
+    /**
+     * Number of threads
+     */
+    int threads;
+
+    /**
+     * Constructor
+     *
+     * @param n Number nodes
+     * @param threads Number of threads
+     */
+    BlockedFloydWarshall(int n, int threads = thread::hardware_concurrency()) :
+        n(n), N((n + B - 1) / B * B), threads(max(1, threads))
+    {
+        dist.assign((size_t) N * N, INF);
+        for (int i = 0; i < N; ++i) {
+            at(i, i) = 0;
+        }
+    }
+
+    /**
+     * Add edge
+     *
+     * @note, must be used before run() is called!
+     */
+    void addEdge(int u, int v, int w)
+    {
+        at(u, v) = min(at(u, v), w);
+    }
+
+    /**
+     * Distance from u to v, INF if unreachable
+     * and -INF if touched by a negative cycle
+     */
+    int get(int u, int v) const
+    {
+        return dist[(size_t) u * N + v];
+    }
+
+    /**
+     * Run blocked Floyd-Warshall
+     */
+    void run()
+    {
+        int blocks = N / B;
+
+        // Three steps per diagonal block kb: the diagonal tile, then its
+        // row and column, then everything else. The threads are started
+        // once and wait on a barrier between steps.
+        auto count = [&](int step) -> ll {
+            switch (step % 3) {
+                case 0: return 1;
+                case 1: return 2 * blocks;
+                default: return (ll) blocks * blocks;
+            }
+        };
+
+        Parallel::parallel_steps(3 * blocks, threads, count, [&](int step, ll t) {
+            int kb = step / 3;
+
+            if (step % 3 == 0) {
+                update(kb, kb, kb);
+            } else if (step % 3 == 1) {
+                int b = t % blocks;
+                if (b == kb) {
+                    return;
+                }
+
+                if (t < blocks) {
+                    update(kb, b, kb);
+                } else {
+                    update(b, kb, kb);
+                }
+            } else {
+                int ib = t / blocks;
+                int jb = t % blocks;
+                if (ib == kb || jb == kb) {
+                    return;
+                }
+
+                update(ib, jb, kb);
+            }
+        });
+
+        mark_negative_cycles();
+    }
+
+private:
+    int & at(int i, int j)
+    {
+        return dist[(size_t) i * N + j];
+    }
+
+    /**
+     * Update tile (ib, jb) through the k values of block kb
+     */
+    void update(int ib, int jb, int kb)
+    {
+        int * C = &at(ib * B, jb * B);
+        const int * A = &at(ib * B, kb * B);
+        const int * K = &at(kb * B, jb * B);
+
+        if (has_avx2()) {
+            kernel_avx2(C, A, K, N);
+        } else {
+            kernel(C, A, K, N);
+        }
+    }
+
+    static bool has_avx2()
+    {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Min-plus tile kernel, C = min(C, A + K), k outermost so that
+     * it is also correct when C aliases A or K (phases 1 and 2)
+     *
+     * @param stride Row stride of the matrix
+     */
+    static void kernel(int * C, const int * A, const int * K, int stride)
+    {
+        for (int k = 0; k < B; ++k) {
+            const int * krow = K + (size_t) k * stride;
+
+            for (int i = 0; i < B; ++i) {
+                int a = A[(size_t) i * stride + k];
+                if (a == INF) {
+                    continue;
+                }
+
+                int * crow = C + (size_t) i * stride;
+                for (int j = 0; j < B; ++j) {
+                    int sum = krow[j] == INF ? INF : max(a + krow[j], -LIMIT);
+                    crow[j] = min(crow[j], sum);
+                }
+            }
+        }
+    }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __attribute__((target("avx2")))
+    static void kernel_avx2(int * C, const int * A, const int * K, int stride)
+    {
+        const __m256i inf = _mm256_set1_epi32(INF);
+        const __m256i floor = _mm256_set1_epi32(-LIMIT);
+
+        for (int k = 0; k < B; ++k) {
+            const int * krow = K + (size_t) k * stride;
+
+            for (int i = 0; i < B; ++i) {
+                int a = A[(size_t) i * stride + k];
+                if (a == INF) {
+                    continue;
+                }
+
+                const __m256i av = _mm256_set1_epi32(a);
+                int * crow = C + (size_t) i * stride;
+
+                for (int j = 0; j < B; j += 8) {
+                    __m256i kv = _mm256_loadu_si256((const __m256i *) (krow + j));
+                    __m256i cv = _mm256_loadu_si256((const __m256i *) (crow + j));
+
+                    // INF lanes of K stay INF, others a + k clamped at -LIMIT
+                    __m256i sum = _mm256_max_epi32(_mm256_add_epi32(av, kv), floor);
+                    __m256i unreachable = _mm256_cmpeq_epi32(kv, inf);
+                    sum = _mm256_blendv_epi8(sum, inf, unreachable);
+
+                    _mm256_storeu_si256((__m256i *) (crow + j), _mm256_min_epi32(cv, sum));
+                }
+            }
+        }
+    }
+#else
+    static void kernel_avx2(int * C, const int * A, const int * K, int stride)
+    {
+        kernel(C, A, K, stride);
+    }
+#endif
+
+    /**
+     * Set d[i][j] = -INF when a negative cycle lies on some path i -> j
+     */
+    void mark_negative_cycles()
+    {
+        // One representative per strongly connected
+        // component containing negative nodes
+        vector<int> reps;
+        for (int k = 0; k < n; ++k) {
+            if (at(k, k) >= 0) {
+                continue;
+            }
+
+            bool seen = false;
+            for (int r : reps) {
+                if (at(r, k) != INF && at(k, r) != INF) {
+                    seen = true;
+                    break;
+                }
+            }
+
+            if (!seen) {
+                reps.push_back(k);
+            }
+        }
+
+        if (reps.empty()) {
+            return;
+        }
+
+        int words = (n + 63) / 64;
+
+        // Nodes reachable from each representative
+        vector<vector<uint64_t>> reach(reps.size(), vector<uint64_t>(words, 0));
+        for (int r = 0; r < reps.size(); ++r) {
+            for (int j = 0; j < n; ++j) {
+                if (at(reps[r], j) != INF) {
+                    reach[r][j / 64] |= 1ULL << (j % 64);
+                }
+            }
+        }
+
+        Parallel::parallel_for(n, threads, [&](int i) {
+            vector<uint64_t> mask(words, 0);
+            for (int r = 0; r < reps.size(); ++r) {
+                if (at(i, reps[r]) == INF) {
+                    continue;
+                }
+
+                for (int w = 0; w < words; ++w) {
+                    mask[w] |= reach[r][w];
+                }
+            }
+
+            for (int j = 0; j < n; ++j) {
+                if (mask[j / 64] >> (j % 64) & 1) {
+                    at(i, j) = -INF;
+                }
+            }
+        });
+    }
+};
+
+/**
+ * All-pairs shortest paths, Johnson's algorithm for sparse graphs
+ * reference: https://en.wikipedia.org/wiki/Johnson%27s_algorithm
+ *
+ * Picks an engine from the density of the graph: Johnson's algorithm
+ * when m * DENSITY < n^2, BlockedFloydWarshall otherwise. Both give the
+ * same distances, INF for unreachable pairs and -INF for pairs with a
+ * negative cycle on some path between them.
+ *
+ * Johnson's algorithm:
+ *
+ * 1. Bellman-Ford from a virtual node with a 0 edge to every node gives
+ *    potentials h with h[v] <= h[u] + w for every edge, so the reweighted
+ *    edges w + h[u] - h[v] are non-negative.
+ * 2. One Dijkstra per source on the reweighted graph, spread over threads.
+ *    d(s, v) = d'(s, v) - h[s] + h[v].
+ *
+ * Negative cycles:
+ *
+ * Let C be the nodes in strongly connected components that contain a
+ * negative cycle. d(s, v) = -INF exactly when s reaches a node of C that
+ * reaches v. Any other s -> v path avoids C entirely, so the remaining
+ * distances are those of the graph without C, which has no negative cycle
+ * and therefore valid potentials. C is found with a second Bellman-Ford
+ * restricted to edges inside components, only if the first one reported
+ * a negative cycle at all.
+ *
+ * Rows can either be stored in an n x n matrix (run()) or handed to a
+ * callback one at a time (run(emit)), which needs only O(n + m) memory
+ * per thread for Johnson's algorithm.
+ *
+ * Time complexity:
+ *
+ * Johnson: O(n * m + n * m * log(n) / threads)
+ * Floyd-Warshall: see BlockedFloydWarshall
+ *
+ * Space complexity:
+ *
+ * O(n^2) materialized, O(threads * n + m) streamed (Johnson)
+ */
+class AllPairs
+{
+public:
+    /**
+     * Johnson's algorithm when m * DENSITY < n^2
+     */
+    static constexpr ll DENSITY = 64;
+
+    /**
+     * Number nodes
+     */
+    int n;
+
+    /**
+     * Number of threads
+     */
+    int threads;
+
+    /**
+     * Edges
+     */
+    vector<BellmanFord::FlatEdge> edges;
+
+    /**
+     * Row-major n x n distances, filled by run()
+     */
+    vector<int> dist;
+
+    /**
+     * Constructor
+     *
+     * @param n Number nodes
+     * @param threads Number of threads
+     */
+    AllPairs(int n, int threads = thread::hardware_concurrency()) : n(n), threads(max(1, threads)) {}
+
+    /**
+     * Add edge
+     *
+     * @note, must be used before run() is called!
+     */
+    void addEdge(int u, int v, int w)
+    {
+        edges.push_back({u, v, w});
+    }
+
+    /**
+     * True if Johnson's algorithm is used
+     */
+    bool sparse() const
+    {
+        return (ll) edges.size() * DENSITY < (ll) n * n;
+    }
+
+    /**
+     * Compute and store all distances
+     */
+    void run()
+    {
+        dist.assign((size_t) n * n, INF);
+
+        if (!sparse()) {
+            floyd_warshall([&](int s, const vector<int> & row) {
+                copy(row.begin(), row.end(), dist.begin() + (size_t) s * n);
+            });
+            return;
+        }
+
+        johnson([&](int s, const vector<int> & row) {
+            copy(row.begin(), row.end(), dist.begin() + (size_t) s * n);
+        });
+    }
+
+    /**
+     * Compute all distances without storing them, emit(s, row) is called
+     * once for every source s with row[v] = d(s, v)
+     *
+     * @note Rows come in no particular order, calls are serialized
+     */
+    void run(const function<void(int, const vector<int> &)> & emit)
+    {
+        if (!sparse()) {
+            floyd_warshall(emit);
+            return;
+        }
+
+        mutex lock;
+        johnson([&](int s, const vector<int> & row) {
+            lock_guard<mutex> guard(lock);
+            emit(s, row);
+        });
+    }
+
+    /**
+     * Distance from u to v after run()
+     */
+    int get(int u, int v) const
+    {
+        return dist[(size_t) u * n + v];
+    }
+
+private:
+    /**
+     * Reweighted graph without C, as CSR
+     */
+    vector<int> offset;
+    vector<int> to;
+    vector<ll> weight;
+
+    /**
+     * Original graph, as CSR
+     */
+    vector<int> all_offset;
+    vector<int> all_to;
+
+    /**
+     * Potentials
+     */
+    vector<ll> h;
+
+    /**
+     * In a component with a negative cycle
+     */
+    vector<char> cyclic;
+
+    /**
+     * Any cyclic node
+     */
+    bool has_cycle = false;
+
+    /**
+     * Per thread buffers
+     */
+    class Workspace
+    {
+    public:
+        vector<ll> d;
+        vector<int> seen;
+        vector<int> bad;
+        vector<int> stack;
+        vector<int> row;
+        int stamp = 0;
+    };
+
+    /**
+     * Dense graphs, rows are emitted from the full matrix
+     */
+    template <class Emit>
+    void floyd_warshall(const Emit & emit)
+    {
+        BlockedFloydWarshall fw(n, threads);
+        for (auto & e : edges) {
+            fw.addEdge(e.u, e.v, e.w);
+        }
+
+        fw.run();
+
+        vector<int> row(n);
+        for (int s = 0; s < n; ++s) {
+            for (int v = 0; v < n; ++v) {
+                row[v] = fw.get(s, v);
+            }
+            emit(s, row);
+        }
+    }
+
+    /**
+     * Potentials from a virtual node n, -INF marks nodes behind a
+     * negative cycle
+     *
+     * @param keep Edges to use
+     */
+    template <class Keep>
+    vector<ll> potentials(Keep keep)
+    {
+        BellmanFord::Graph G(n + 1, edges.size() + n);
+        for (auto & e : edges) {
+            if (keep(e)) {
+                G.add_edge(e.u, e.v, e.w);
+            }
+        }
+
+        for (int v = 0; v < n; ++v) {
+            G.add_edge(n, v, 0);
+        }
+
+        BellmanFord::BellmanFord bf(move(G), n);
+        bf.run();
+
+        bf.dist.pop_back();
+        return bf.dist;
+    }
+
+    /**
+     * Strongly connected components of the original graph,
+     * iterative Tarjan
+     */
+    vector<int> components()
+    {
+        vector<int> comp(n, -1), index(n, -1), low(n, 0), edge(n, 0);
+        vector<int> stack, call;
+        int counter = 0, count = 0;
+
+        for (int r = 0; r < n; ++r) {
+            if (index[r] != -1) {
+                continue;
+            }
+
+            call.push_back(r);
+            while (!call.empty()) {
+                int u = call.back();
+
+                if (index[u] == -1) {
+                    index[u] = low[u] = counter++;
+                    edge[u] = all_offset[u];
+                    stack.push_back(u);
+                }
+
+                // Descend into the next unvisited child
+                bool descended = false;
+                while (edge[u] < all_offset[u + 1]) {
+                    int v = all_to[edge[u]++];
+                    if (index[v] == -1) {
+                        call.push_back(v);
+                        descended = true;
+                        break;
+                    }
+
+                    if (comp[v] == -1) {
+                        low[u] = min(low[u], index[v]);
+                    }
+                }
+
+                if (descended) {
+                    continue;
+                }
+
+                call.pop_back();
+                if (!call.empty()) {
+                    low[call.back()] = min(low[call.back()], low[u]);
+                }
+
+                if (low[u] == index[u]) {
+                    int v;
+                    do {
+                        v = stack.back();
+                        stack.pop_back();
+                        comp[v] = count;
+                    } while (v != u);
+                    count++;
+                }
+            }
+        }
+
+        return comp;
+    }
+
+    /**
+     * Build the CSR graphs, find C and the potentials
+     */
+    void prepare()
+    {
+        all_offset.assign(n + 1, 0);
+        for (auto & e : edges) {
+            all_offset[e.u + 1]++;
+        }
+        for (int v = 0; v < n; ++v) {
+            all_offset[v + 1] += all_offset[v];
+        }
+
+        all_to.resize(edges.size());
+        vector<int> pos(all_offset.begin(), all_offset.end() - 1);
+        for (auto & e : edges) {
+            all_to[pos[e.u]++] = e.v;
+        }
+
+        cyclic.assign(n, false);
+        h = potentials([](auto &) { return true; });
+        has_cycle = any_of(h.begin(), h.end(), [](ll x) { return x == -BellmanFord::INF; });
+
+        if (has_cycle) {
+            // Negative cycles live inside one component
+            vector<int> comp = components();
+            vector<ll> inner = potentials([&](auto & e) { return comp[e.u] == comp[e.v]; });
+            for (int v = 0; v < n; ++v) {
+                cyclic[v] = inner[v] == -BellmanFord::INF;
+            }
+
+            h = potentials([&](auto & e) { return !cyclic[e.u] && !cyclic[e.v]; });
+        }
+
+        offset.assign(n + 1, 0);
+        for (auto & e : edges) {
+            if (!cyclic[e.u] && !cyclic[e.v]) {
+                offset[e.u + 1]++;
+            }
+        }
+        for (int v = 0; v < n; ++v) {
+            offset[v + 1] += offset[v];
+        }
+
+        to.resize(offset[n]);
+        weight.resize(offset[n]);
+        pos.assign(offset.begin(), offset.end() - 1);
+        for (auto & e : edges) {
+            if (!cyclic[e.u] && !cyclic[e.v]) {
+                to[pos[e.u]] = e.v;
+                weight[pos[e.u]++] = e.w + h[e.u] - h[e.v];
+            }
+        }
+    }
+
+    /**
+     * Fill ws.row with the distances from s
+     */
+    void row(int s, Workspace & ws)
+    {
+        auto & row = ws.row;
+        row.assign(n, INF);
+        ws.stamp++;
+
+        // -INF: reachable from s through C
+        if (has_cycle) {
+            auto & stack = ws.stack;
+            stack = {s};
+            ws.seen[s] = ws.stamp;
+
+            vector<int> seeds;
+            while (!stack.empty()) {
+                int u = stack.back();
+                stack.pop_back();
+
+                if (cyclic[u]) {
+                    seeds.push_back(u);
+                    ws.bad[u] = ws.stamp;
+                }
+
+                for (int i = all_offset[u]; i < all_offset[u + 1]; ++i) {
+                    int v = all_to[i];
+                    if (ws.seen[v] != ws.stamp) {
+                        ws.seen[v] = ws.stamp;
+                        stack.push_back(v);
+                    }
+                }
+            }
+
+            stack = move(seeds);
+            while (!stack.empty()) {
+                int u = stack.back();
+                stack.pop_back();
+                row[u] = -INF;
+
+                for (int i = all_offset[u]; i < all_offset[u + 1]; ++i) {
+                    int v = all_to[i];
+                    if (ws.bad[v] != ws.stamp) {
+                        ws.bad[v] = ws.stamp;
+                        stack.push_back(v);
+                    }
+                }
+            }
+
+            if (cyclic[s]) {
+                return;
+            }
+        }
+
+        // Dijkstra on the reweighted graph
+        auto & d = ws.d;
+        priority_queue<pair<ll, int>, vector<pair<ll, int>>, greater<>> pq;
+        d[s] = 0;
+        ws.seen[s] = -ws.stamp;
+        pq.push({0, s});
+
+        while (!pq.empty()) {
+            auto [du, u] = pq.top();
+            pq.pop();
+
+            if (du > d[u]) {
+                continue;
+            }
+
+            if (row[u] != -INF) {
+                row[u] = (int) (du - h[s] + h[u]);
+            }
+
+            for (int i = offset[u]; i < offset[u + 1]; ++i) {
+                int v = to[i];
+                ll alt = du + weight[i];
+
+                // seen[v] == -stamp marks d[v] as set in this run
+                if (ws.seen[v] != -ws.stamp || alt < d[v]) {
+                    ws.seen[v] = -ws.stamp;
+                    d[v] = alt;
+                    pq.push({alt, v});
+                }
+            }
+        }
+    }
+
+    /**
+     * Johnson's algorithm, emit(s, row) from worker threads
+     */
+    template <class Emit>
+    void johnson(const Emit & emit)
+    {
+        prepare();
+
+        // One workspace per thread, set up on first use
+        vector<Workspace> spaces(threads);
+
+        Parallel::parallel_for(n, threads, [&](int s, int t) {
+            Workspace & ws = spaces[t];
+            if (ws.d.empty()) {
+                ws.d.assign(n, 0);
+                ws.seen.assign(n, 0);
+                ws.bad.assign(n, 0);
+            }
+
+            row(s, ws);
+            emit(s, ws.row);
+        });
+    }
+};
+
+/**
+ * Random dense graph for the benchmark, non-negative weights
+ */
+template <class FW>
+void random_edges(FW & fw, int n, int m, mt19937 & rng)
+{
+    for (int i = 0; i < m; ++i) {
+        fw.addEdge(rng() % n, rng() % n, rng() % 1000);
+    }
+}
+
+/**
+ * Benchmark against the original FloydWarshall
+ */
+int bench()
+{
+    bool ok = true;
+
+    // The original O(n^3) loop takes minutes at n = 4000,
+    // so it is only timed (and compared) up to ORIGINAL_MAX
+    const int ORIGINAL_MAX = 2000;
+
+    for (int n : {500, 1000, 2000, 4000}) {
+        int m = 4 * n;
+        cout << "n = " << n << ", m = " << m << "\n";
+
+        mt19937 rng(n);
+        BlockedFloydWarshall blocked(n);
+        random_edges(blocked, n, m, rng);
+
+        auto start = chrono::steady_clock::now();
+        blocked.run();
+        auto end = chrono::steady_clock::now();
+        cout << "  blocked (" << blocked.threads << " threads): "
+             << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        if (n > ORIGINAL_MAX) {
+            continue;
+        }
+
+        rng.seed(n);
+        FloydWarshall fw(n);
+        random_edges(fw, n, m, rng);
+
+        start = chrono::steady_clock::now();
+        fw.run();
+        end = chrono::steady_clock::now();
+        cout << "  original: " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                ok = ok && fw.dist[i][j] == blocked.get(i, j);
+            }
+        }
+    }
+
+    // Sparse graphs, a few edges per node, some negative
+    for (int n : {1000, 2000}) {
+        int m = 4 * n;
+        cout << "sparse n = " << n << ", m = " << m << "\n";
+
+        mt19937 rng(n);
+        AllPairs johnson(n);
+        BlockedFloydWarshall blocked(n);
+        for (int i = 0; i < m; ++i) {
+            int u = rng() % n, v = rng() % n, w = (int) (rng() % 1000) - 5;
+            johnson.addEdge(u, v, w);
+            blocked.addEdge(u, v, w);
+        }
+
+        auto start = chrono::steady_clock::now();
+        johnson.run();
+        auto end = chrono::steady_clock::now();
+        cout << "  johnson (" << johnson.threads << " threads): "
+             << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        start = chrono::steady_clock::now();
+        blocked.run();
+        end = chrono::steady_clock::now();
+        cout << "  blocked: " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                ok = ok && johnson.get(i, j) == blocked.get(i, j);
+            }
+        }
+    }
+
+    // Streamed rows, the matrix alone would take 400 MB
+    {
+        int n = 10000, m = 4 * n;
+        mt19937 rng(n);
+        AllPairs johnson(n);
+        for (int i = 0; i < m; ++i) {
+            johnson.addEdge(rng() % n, rng() % n, rng() % 1000);
+        }
+
+        ll reachable = 0;
+        auto start = chrono::steady_clock::now();
+        johnson.run([&](int, const vector<int> & row) {
+            reachable += count_if(row.begin(), row.end(), [](int d) { return d != INF; });
+        });
+        auto end = chrono::steady_clock::now();
+        cout << "streamed n = " << n << ", m = " << m << ": "
+             << chrono::duration<double, milli>(end - start).count() << " ms, "
+             << reachable << " reachable pairs\n";
+    }
+
+    cout << (ok ? "ok" : "MISMATCH") << endl;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char ** argv)
 {
     cin.sync_with_stdio(false);
     cin.tie(nullptr);
 
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
+
     int n, m, q;
 
     while (1) {
@@ -151,7 +1050,7 @@ int main()
             break;
         }
 
-        FloydWarshall fw(n);
+        AllPairs fw(n);
 
         int u, v, w;
         for (int i = 0; i < m; i++) {
@@ -164,17 +1063,17 @@ int main()
         for (int i = 0; i < q; i++) {
             cin >> u >> v;
 
-            if (fw.dist[u][v] == INT_MAX) {
+            if (fw.get(u, v) == INT_MAX) {
                 cout << "Impossible\n";
                 continue;
             }
 
-            if (fw.dist[u][v] == -INF) {
+            if (fw.get(u, v) == -INF) {
                 cout << "-Infinity\n";
                 continue;
             }
 
-            cout << fw.dist[u][v] << "\n";
+            cout << fw.get(u, v) << "\n";
         }
     }
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <sstream>
+#include <algorithm>
+#include "../util/textindex.cpp"
 
 /**
  * @author Oskar Arensmeier
@@ -13,7 +16,8 @@
  *
  * Algorithm:
  * The only difference to the basic suffix array is that
- * the LCP array is computed after the suffix array is built.
+ * the LCP array is computed after the suffix array is built
+ * (with SA-IS, util/suffixarray.cpp).
  *
  * This works by using the inverse suffix array (rank) to find
  * the longest common prefix between consecutive suffixes. It exploits
@@ -28,14 +32,19 @@
  *
  * Usage:
  * Only supporting ASCII characters!
+ *
+ * Reusable index:
+ * dvaput build <file>  reads a text from stdin and saves its TextIndex
+ *                      (util/textindex.cpp) to <file>
+ * dvaput query <file>  maps the saved index and answers one query per line:
+ *                      count <pattern>, locate <pattern>, lce <i> <j>, repeat
  */
 
 using namespace std;
+using ll = long long;
 
 class SuffixArray {
 
-static const int ALPHABET_SIZE = 256; // ASCII size
-
 public:
 
 /**
@@ -53,15 +62,9 @@ vector<int> lcp;
  *
  * @param str String
  */
-SuffixArray(const string & str)
+SuffixArray(const string & str) : str(str)
 {
-    // Append unique char
-    this->str = str + (char) 0x1;
-    this->suffix = sort_cyclic_shifts(this->str);
-    this->str = this->str.substr(0, this->str.size() - 1);
-
-    // Remove '0x1'
-    this->suffix.erase(this->suffix.begin());
+    this->suffix = SAIS::suffix_array<int>(this->str);
 
     build_lcp();
 }
@@ -87,94 +90,6 @@ private:
  */
 string str;
 
-/**
- * Sort cyclic shifts of the string
- *
- * @param s String
- * @return Sorted suffixes
- */
-vector<int> sort_cyclic_shifts(string const& s) {
-    int n = s.size();
-    vector<int> perm(n);                       // Permutation of indices
-    vector<int> cls(n);                        // Equivalence classes
-    vector<int> cnt(max(ALPHABET_SIZE, n), 0); // Count of chars - for count sort
-
-    /* 
-    Inital phase sorts based on single char,
-    and creates first equivalence classes.
-    */
-
-    for (int i = 0; i < n; i++) {
-        cnt[s[i]]++;
-    }
-    for (int i = 1; i < ALPHABET_SIZE; i++) {
-        cnt[i] += cnt[i-1];
-    }
-    for (int i = 0; i < n; i++) {
-        perm[--cnt[s[i]]] = i;
-    }
-
-    cls[perm[0]] = 0;
-    int cls_count = 1;
-    for (int i = 1; i < n; i++) {
-        if (s[perm[i]] != s[perm[i-1]]) {
-            cls_count++;
-        }
-
-        cls[perm[i]] = cls_count - 1;
-    }
-
-    vector<int> perm_tmp(n);
-    vector<int> cls_tmp(n);
-
-    /* 
-    Second phase continuously increases the length of the cyclic shifts
-    being sorted, doubling the length each iteration.
-    */
-
-    for (int h = 0; (1 << h) < n; ++h) {
-
-        for (int i = 0; i < n; i++) {
-            perm_tmp[i] = perm[i] - (1 << h);
-
-            if (perm_tmp[i] < 0) {
-                perm_tmp[i] += n;
-            }
-        }
-
-        fill(cnt.begin(), cnt.begin() + cls_count, 0);
-
-        for (int i = 0; i < n; i++) {
-            cnt[cls[perm_tmp[i]]]++;
-        }
-        for (int i = 1; i < cls_count; i++) {
-            cnt[i] += cnt[i-1];
-        }
-        for (int i = n-1; i >= 0; i--) {
-            perm[--cnt[cls[perm_tmp[i]]]] = perm_tmp[i];
-        }
-
-        // Radix like idea using the previous equivalence classes
-        cls_tmp[perm[0]] = 0;
-        cls_count = 1;
-        for (int i = 1; i < n; i++) {
-
-            pair<int, int> cur  = {cls[perm[i]],   cls[(perm[i]   + (1 << h)) % n]};
-            pair<int, int> prev = {cls[perm[i-1]], cls[(perm[i-1] + (1 << h)) % n]};
-
-            if (cur != prev) {
-                ++cls_count;
-            }
-
-            cls_tmp[perm[i]] = cls_count - 1;
-        }
-
-        cls.swap(cls_tmp);
-    }
-
-    return perm;
-}
-
 /**
  * Build LCP array
  *
@@ -182,40 +97,10 @@ vector<int> sort_cyclic_shifts(string const& s) {
  */
 void build_lcp()
 {
-    int n = str.size();
-
-    // Inverse suffix arr
-    vector<int> rank(n, 0);
-    for (int i = 0; i < n; i++) {
-        rank[suffix[i]] = i;
-    }
-
-    int k = 0;
-    lcp.resize(n - 1, 0);
-    for (int i = 0; i < n; i++) {
-
-        // Largest suffix has no successor
-        if (rank[i] == n - 1) {
-            k = 0;
-            continue;
-        }
-
-        // Get suffix after i
-        int j = suffix[rank[i] + 1];
-
-        // Check if we can improve LCP for this pair
-        while (i + k < n && j + k < n && str[i+k] == str[j+k]) {
-            k++;
-        }
-
-        // Store the computed LCP.
-        lcp[rank[i]] = k;
-
-        // If k > 0, lcp for next pair is at least k-1.
-        if (k) {
-            k--;
-        }
-    }
+    // Kasai gives lcp[i] with the previous suffix,
+    // here lcp[i] is with the next one
+    lcp = SAIS::lcp_array(str, suffix);
+    lcp.erase(lcp.begin());
 }
 };
 
@@ -240,11 +125,91 @@ vector<string> split_str(const string & s, char delim)
     return tokens;
 }
 
-int main()
+/**
+ * Answer queries from stdin against a text index. A malformed query is
+ * reported on stderr and skipped, the remaining lines are still answered.
+ */
+template <class Index>
+int answer_queries(const SAIS::TextIndex<Index> & index)
+{
+    string line;
+    while (getline(cin, line)) {
+        istringstream in(line);
+        string op;
+        in >> op;
+
+        try {
+            if (op == "count" || op == "locate") {
+                // Rest of the line after one space is the pattern
+                string pattern = line.size() > op.size() ? line.substr(op.size() + 1) : "";
+
+                if (op == "count") {
+                    cout << index.count(pattern) << '\n';
+                    continue;
+                }
+
+                vector<Index> positions = index.locate(pattern);
+                sort(positions.begin(), positions.end());
+                cout << positions.size();
+                for (Index p : positions) {
+                    cout << ' ' << p;
+                }
+                cout << '\n';
+            } else if (op == "lce") {
+                ll i, j;
+                if (!(in >> i >> j)) {
+                    throw invalid_argument("lce needs two positions");
+                }
+
+                // Check before narrowing to Index
+                if (i < 0 || j < 0 || i >= (ll) index.size() || j >= (ll) index.size()) {
+                    throw out_of_range("Position out of range");
+                }
+
+                cout << index.lce(i, j) << '\n';
+            } else if (op == "repeat") {
+                auto [length, position] = index.longest_repeat();
+                cout << length << ' ' << position << '\n';
+            } else if (!op.empty()) {
+                throw invalid_argument("Unknown query: " + op);
+            }
+        } catch (const exception & e) {
+            cerr << e.what() << ": " << line << '\n';
+        }
+    }
+
+    cout << flush;
+    return 0;
+}
+
+int main(int argc, char ** argv)
 {
     cin.tie(nullptr);
     cin.sync_with_stdio(false);
 
+    try {
+        if (argc > 2 && string(argv[1]) == "build") {
+            string text((istreambuf_iterator<char>(cin)), istreambuf_iterator<char>());
+
+            if (SAIS::fits_32(text.size())) {
+                SAIS::TextIndex<int32_t>(text).save(argv[2]);
+            } else {
+                SAIS::TextIndex<int64_t>(text).save(argv[2]);
+            }
+            return 0;
+        }
+
+        if (argc > 2 && string(argv[1]) == "query") {
+            if (SAIS::stored_width(argv[2]) == sizeof(int32_t)) {
+                return answer_queries(*SAIS::TextIndex<int32_t>::open(argv[2]));
+            }
+            return answer_queries(*SAIS::TextIndex<int64_t>::open(argv[2]));
+        }
+    } catch (const exception & e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
     string str;
 
     getline(cin, str);
@@ -1,4 +1,11 @@
 #include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <string>
+
+#include "../util/fenwick.cpp"
+#include "../util/bench.cpp"
 
 /**
  * @author Oskar Arensmeier
@@ -49,6 +56,10 @@
  * 
  * Data structures:
  * - Array to store partial sums indexed by the Fenwick tree structure
+ *
+ * The tree itself lives in util/fenwick.cpp as FenwickTree<T, Op>, next to
+ * range-add/range-sum, 2D and lazy segment tree variants; bench() times
+ * each of them on mixed streams of 10^7 operations.
  */
 
 /* Complementary work  
@@ -63,61 +74,171 @@ This means for m queries, the total time complexity would be O(nm).
 
 */
 
-#define ll long long int
-
 using namespace std;
+using ll = long long;
 
-class FenwickTree {
-public:
+/**
+ * Time mixed update/query streams of 10^7 operations on each structure,
+ * cross-checking RangeFenwick against LazySegmentTree<AddSum>
+ */
+int bench()
+{
+    const int OPS = 10000000;
+    const int n = 1000000;
 
-    ll n;
-    ll * arr;
+    mt19937 rng(1);
+    bool ok = true;
 
-    FenwickTree(ll n): n(n) {
-        arr = new ll[n+1]();
+    vector<ll> a(n);
+    for (ll & x : a) {
+        x = rng() % 1000;
     }
 
-    ~FenwickTree() {
-        delete[] arr;
+    cout << "n = " << n << ", " << OPS << " operations each\n";
+
+    {
+        double t = Bench::time([&] {
+            FenwickTree<ll> ft(n);
+            for (int i = 0; i < n; ++i) {
+                ft.add(i, a[i]);
+            }
+        });
+        cout << "  build by n adds: " << t << " ms\n";
+
+        t = Bench::time([&] { FenwickTree<ll> ft(a); });
+        cout << "  build in O(n): " << t << " ms\n";
     }
 
-    /**
-     * Add value to index i
-     * @param i index
-     * @param val value
-     */
-    void add(ll i, ll val)
     {
-        i += 1; // 1-indexed
-        for (; i <= this->n; i += i & (-i)) {
-            this->arr[i] += val;
-        }
+        FenwickTree<ll> ft(a);
+        ll check = 0;
+        double t = Bench::time([&] {
+            for (int k = 0; k < OPS; ++k) {
+                uint32_t r = rng();
+                if (r & 1) {
+                    ft.add(r % n, r % 1000);
+                } else {
+                    check += ft.sum(r % (n + 1));
+                }
+            }
+        });
+        cout << "  point add / prefix sum: " << t << " ms (" << check << ")\n";
+    }
+
+    {
+        FenwickTree<ll> ft(a);
+        ll total = ft.sum(n);
+        ll check = 0;
+        double t = Bench::time([&] {
+            for (int k = 0; k < OPS; ++k) {
+                uint32_t r = rng();
+                if (r & 1) {
+                    ft.add(r % n, r % 1000);
+                    total += r % 1000;
+                } else {
+                    check += ft.lower_bound(r % total);
+                }
+            }
+        });
+        cout << "  point add / lower_bound: " << t << " ms (" << check << ")\n";
     }
 
-    /**
-     * Get sum of elements of first i elements
-     * @param i amount of elements
-     * @return sum
-     */
-    ll sum(ll i)
     {
-        ll res = 0;
-        for(; i > 0; i -= i & (-i)) {
-            res += this->arr[i];
+        vector<uint32_t> ops(OPS);
+        for (uint32_t & r : ops) {
+            r = rng();
         }
 
-        return res;
+        auto range = [&](uint32_t r) {
+            int l = r % n;
+            int len = (r >> 8) % 1000 + 1;
+            return pair<int, int>(l, min(n, l + len));
+        };
+
+        RangeFenwick<ll> rf(a);
+        ll fenwick_check = 0;
+        double t = Bench::time([&] {
+            for (uint32_t r : ops) {
+                auto [l, rr] = range(r);
+                if (r & 1) {
+                    rf.add(l, rr, r % 100);
+                } else {
+                    fenwick_check += rf.sum(l, rr);
+                }
+            }
+        });
+        cout << "  range add / range sum, RangeFenwick: " << t << " ms\n";
+
+        vector<pair<ll, ll>> leaves(n);
+        for (int i = 0; i < n; ++i) {
+            leaves[i] = {a[i], 1};
+        }
+
+        LazySegmentTree<AddSum<ll>> st(leaves);
+        ll segment_check = 0;
+        t = Bench::time([&] {
+            for (uint32_t r : ops) {
+                auto [l, rr] = range(r);
+                if (r & 1) {
+                    st.apply(l, rr, r % 100);
+                } else {
+                    segment_check += st.query(l, rr).first;
+                }
+            }
+        });
+        cout << "  range add / range sum, LazySegmentTree: " << t << " ms\n";
+
+        ok = ok && fenwick_check == segment_check;
+
+        LazySegmentTree<AddMin<ll>> mn(a);
+        ll check = 0;
+        t = Bench::time([&] {
+            for (uint32_t r : ops) {
+                auto [l, rr] = range(r);
+                if (r & 1) {
+                    mn.apply(l, rr, (ll) (r % 100) - 50);
+                } else {
+                    check += mn.query(l, rr);
+                }
+            }
+        });
+        cout << "  range add / range min, LazySegmentTree: " << t << " ms (" << check << ")\n";
     }
-};
 
-int main()
+    {
+        const int side = 1000;
+        Fenwick2D<ll> f2(side, side);
+        ll check = 0;
+        double t = Bench::time([&] {
+            for (int k = 0; k < OPS; ++k) {
+                uint32_t r = rng();
+                int x = r % side;
+                int y = (r >> 10) % side;
+                if (r & 1) {
+                    f2.add(x, y, r % 1000);
+                } else {
+                    check += f2.sum(x / 2, y / 2, x + 1, y + 1);
+                }
+            }
+        });
+        cout << "  2D point add / rectangle sum (" << side << "x" << side << "): " << t << " ms (" << check << ")\n";
+    }
+
+    return Bench::report(ok);
+}
+
+int main(int argc, char ** argv)
 {
     cin.sync_with_stdio(false);
     cin.tie(nullptr);
 
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
+
     ll N, Q;
     cin >> N >> Q;
-    FenwickTree ft(N);
+    FenwickTree<ll> ft(N);
 
     char op;
     ll x, y;
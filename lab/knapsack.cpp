@@ -22,13 +22,89 @@
  *
  * The nested loops is O(n * m) where n is the number of items and m is the capacity.
  * Each operation inside the loops is O(1). Overall complexity is O(n * m).
+ *
+ * # Memory-lean variant
+ *
+ * cover() keeps n * m cells. cover_lean() instead keeps a single row of values,
+ * updated in place with the capacity loop running downwards, and recovers the
+ * items by divide and conquer (Hirschberg): the best values for the first and
+ * second half of the items tell how to split the capacity between the halves,
+ * and each half is solved recursively. Subproblems small enough are solved with
+ * a bit table. O(n * m) time, O(m) memory.
+ *
+ * # Variants
+ *
+ * - subset_sum(): feasibility only (value == weight), a bitset of reachable sums
+ *   shifted and or-ed 64 sums per word.
+ * - cover_bounded(): item i at most counts[i] times, binary splitting into 0/1 items.
+ * - cover_unbounded(): any number of each item, a single ascending row.
  */
 
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <thread>
+#include <barrier>
+#include <string>
+#include <chrono>
+#include <random>
+#include <optional>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
 
 using namespace std;
+using ll = long long;
+
+/**
+ * Rows shorter than this per thread are not split across threads
+ */
+const int PARALLEL_MIN_CAPACITY = 1 << 16;
+
+/**
+ * Subproblems with at most this many item x capacity
+ * cells are solved directly by cover_lean()
+ */
+const ll DIRECT_CELLS = 1 << 22;
+
+/**
+ * Vectorize the row updates: an AVX2 and a baseline clone picked at load
+ * time, and a cost model that accepts the loops at -O2
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define VECTORIZE __attribute__((target_clones("avx2", "default"), optimize("vect-cost-model=dynamic")))
+#else
+#define VECTORIZE
+#endif
+
+/**
+ * row[c] = max(row[c], row[c - weight] + value) for c from capacity down to weight
+ *
+ * Each row[c - weight] is read before it is overwritten, so
+ * the loop carries no dependency that blocks vectorization.
+ */
+VECTORIZE
+void add_item(ll * row, int capacity, int weight, ll value)
+{
+#pragma GCC ivdep
+    for (int c = capacity; c >= weight; --c) {
+        row[c] = max(row[c], row[c - weight] + value);
+    }
+}
+
+/**
+ * next[c] = max(prev[c], prev[c - weight] + value) for c in [lo, hi)
+ */
+VECTORIZE
+void add_item(const ll * prev, ll * next, int lo, int hi, int weight, ll value)
+{
+    for (int c = lo; c < min(hi, weight); ++c) {
+        next[c] = prev[c];
+    }
+    for (int c = max(lo, weight); c < hi; ++c) {
+        next[c] = max(prev[c], prev[c - weight] + value);
+    }
+}
 
 /**
  * Solve the 0/1 knapsack problem
@@ -87,11 +163,524 @@ vector<int> cover(
     return indices;
 }
 
-int main()
+/**
+ * Best value for every capacity 0..capacity using items [first, last),
+ * one rolling row
+ *
+ * The capacity loop runs downwards so the row can be updated in place:
+ * row[c - weight] still holds the value without the current item. With
+ * more than one thread the capacity range is split between threads and
+ * two rows are used instead, swapping after each item.
+ *
+ * @param capacity Knapsack capacity
+ * @param items List of items with value and weight
+ * @param first First item
+ * @param last One past the last item
+ * @param threads Number of threads
+ * @return row[c] = best value with total weight at most c
+ */
+vector<ll> best_values(
+    int capacity,
+    const vector<pair<int, int>>& items,
+    int first,
+    int last,
+    int threads = 1
+) {
+    // Splitting only pays off for long rows
+    threads = max(1, min(threads, (capacity + 1) / PARALLEL_MIN_CAPACITY));
+
+    vector<ll> row(capacity + 1, 0);
+
+    if (threads == 1) {
+        for (int i = first; i < last; ++i) {
+            add_item(row.data(), capacity, items[i].second, items[i].first);
+        }
+
+        return row;
+    }
+
+    // Item i reads rows[i % 2] and writes rows[(i + 1) % 2]
+    vector<ll> other(capacity + 1, 0);
+    ll * rows[2] = {row.data(), other.data()};
+    barrier sync(threads);
+
+    auto worker = [&](int t) {
+        int lo = (ll) (capacity + 1) * t / threads;
+        int hi = (ll) (capacity + 1) * (t + 1) / threads;
+
+        for (int i = first; i < last; ++i) {
+            const ll * prev = rows[(i - first) % 2];
+            ll * next = rows[(i - first + 1) % 2];
+            add_item(prev, next, lo, hi, items[i].second, items[i].first);
+
+            sync.arrive_and_wait();
+        }
+    };
+
+    vector<thread> pool;
+    for (int t = 1; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+
+    for (auto & th : pool) {
+        th.join();
+    }
+
+    if ((last - first) % 2 == 1) {
+        swap(row, other);
+    }
+
+    return row;
+}
+
+/**
+ * Collect the items [first, last) of an optimal solution with
+ * total weight at most capacity (divide and conquer, Hirschberg)
+ *
+ * Both halves of the items get a best_values() row, and the split
+ * c + (capacity - c) maximizing left[c] + right[capacity - c] tells how
+ * much capacity each half uses in an optimal solution. Small subproblems
+ * are solved directly with a bit table for the backtrace.
+ */
+void collect(
+    int capacity,
+    const vector<pair<int, int>>& items,
+    int first,
+    int last,
+    int threads,
+    vector<int>& indices
+) {
+    if (first >= last) {
+        return;
+    }
+
+    // One item, also ends the recursion when a single
+    // row is longer than DIRECT_CELLS
+    if (last - first == 1) {
+        if (items[first].second <= capacity && items[first].first > 0) {
+            indices.push_back(first);
+        }
+        return;
+    }
+
+    // Table with one bit per item and capacity, fits in cache
+    if ((ll) (last - first) * (capacity + 1) <= DIRECT_CELLS) {
+        vector<ll> row(capacity + 1, 0);
+        vector<bool> taken((ll) (last - first) * (capacity + 1), false);
+
+        for (int i = first; i < last; ++i) {
+            ll value = items[i].first;
+            int weight = items[i].second;
+            ll offset = (ll) (i - first) * (capacity + 1);
+
+            for (int c = capacity; c >= weight; --c) {
+                if (row[c - weight] + value > row[c]) {
+                    row[c] = row[c - weight] + value;
+                    taken[offset + c] = true;
+                }
+            }
+        }
+
+        int c = capacity;
+        for (int i = last - 1; i >= first; --i) {
+            if (taken[(ll) (i - first) * (capacity + 1) + c]) {
+                indices.push_back(i);
+                c -= items[i].second;
+            }
+        }
+
+        return;
+    }
+
+    int mid = first + (last - first) / 2;
+    int split = 0;
+    {
+        vector<ll> left = best_values(capacity, items, first, mid, threads);
+        vector<ll> right = best_values(capacity, items, mid, last, threads);
+
+        for (int c = 0; c <= capacity; ++c) {
+            if (left[c] + right[capacity - c] > left[split] + right[capacity - split]) {
+                split = c;
+            }
+        }
+    }
+
+    collect(split, items, first, mid, threads, indices);
+    collect(capacity - split, items, mid, last, threads, indices);
+}
+
+/**
+ * Solve the 0/1 knapsack problem in O(capacity) memory
+ * and returns indices of items used in the solution.
+ *
+ * Same result value as cover() in O(n * capacity) time, about
+ * twice the work of a single pass, but only a few rows of memory.
+ *
+ * @param capacity Knapsack capacity
+ * @param items List of items with value and weight
+ * @param threads Number of threads for each row
+ * @return List of indices of items used in solution
+ */
+vector<int> cover_lean(
+    int capacity,
+    const vector<pair<int, int>>& items,
+    int threads = 1
+) {
+    vector<int> indices;
+    collect(capacity, items, 0, items.size(), threads, indices);
+
+    sort(indices.begin(), indices.end());
+    return indices;
+}
+
+/**
+ * Shift-or step of subset_sum(): reach |= reach << weight, with
+ * added[j] = the bits new in word j
+ *
+ * Words run downwards, so reach[j - q] and reach[j - q - 1] are
+ * read before they are updated, as in add_item().
+ */
+VECTORIZE
+void shift_or(uint64_t * reach, uint64_t * added, int words, int weight)
+{
+    int q = weight / 64, r = weight % 64;
+
+    if (r == 0) {
+#pragma GCC ivdep
+        for (int j = words - 1; j >= q; --j) {
+            uint64_t shifted = reach[j - q];
+            added[j] = shifted & ~reach[j];
+            reach[j] |= shifted;
+        }
+    } else {
+#pragma GCC ivdep
+        for (int j = words - 1; j > q; --j) {
+            uint64_t shifted = reach[j - q] << r | reach[j - q - 1] >> (64 - r);
+            added[j] = shifted & ~reach[j];
+            reach[j] |= shifted;
+        }
+
+        if (q < words) {
+            uint64_t shifted = reach[0] << r;
+            added[q] = shifted & ~reach[q];
+            reach[q] |= shifted;
+        }
+    }
+
+    for (int j = 0; j < min(q, words); ++j) {
+        added[j] = 0;
+    }
+}
+
+/**
+ * Find items whose weights sum to exactly target (subset sum)
+ *
+ * Reachable sums are kept as a bitset, and each item shifts and ors it
+ * onto itself 64 sums per word (AVX2 clone when the CPU has it). The
+ * item that first reaches a sum is recorded, which is all the backtrace
+ * needs: that item's sum minus its weight was reachable with earlier
+ * items only.
+ *
+ * Time complexity: O(n * target / 64 + target)
+ * Space complexity: O(target)
+ *
+ * @param target Sum to reach
+ * @param weights Non-negative item weights
+ * @return Indices of items summing to target, nullopt if impossible
+ */
+optional<vector<int>> subset_sum(int target, const vector<int>& weights)
+{
+    if (target < 0) {
+        return nullopt;
+    }
+
+    int words = target / 64 + 1;
+    vector<uint64_t> reach(words, 0), added(words, 0);
+    vector<int> first(target + 1, -1);
+    reach[0] = 1;
+
+    for (int i = 0; i < (int) weights.size(); ++i) {
+        if (weights[i] <= 0 || weights[i] > target) {
+            continue;
+        }
+
+        shift_or(reach.data(), added.data(), words, weights[i]);
+
+        for (int j = 0; j < words; ++j) {
+            for (uint64_t bits = added[j]; bits != 0; bits &= bits - 1) {
+                int s = j * 64 + __builtin_ctzll(bits);
+                if (s <= target) {
+                    first[s] = i;
+                }
+            }
+        }
+
+        if (first[target] != -1) {
+            break;
+        }
+    }
+
+    if (target > 0 && first[target] == -1) {
+        return nullopt;
+    }
+
+    vector<int> indices;
+    for (int s = target; s > 0; s -= weights[first[s]]) {
+        indices.push_back(first[s]);
+    }
+
+    sort(indices.begin(), indices.end());
+    return indices;
+}
+
+/**
+ * Solve the bounded knapsack problem, item i may be used up to counts[i] times
+ *
+ * Each item is split into copies of 1, 2, 4, .. units plus the rest,
+ * which can add up to any count from 0 to counts[i], and the copies go
+ * through cover_lean() as a 0/1 problem.
+ *
+ * Time complexity: O(capacity * sum(log counts[i]))
+ *
+ * @param capacity Knapsack capacity
+ * @param items List of items with value and weight
+ * @param counts Copies available of each item
+ * @param threads Number of threads for each row
+ * @return Indices of items used, each repeated once per copy
+ */
+vector<int> cover_bounded(
+    int capacity,
+    const vector<pair<int, int>>& items,
+    const vector<int>& counts,
+    int threads = 1
+) {
+    if (items.size() != counts.size()) {
+        throw invalid_argument("items and counts must have the same size");
+    }
+
+    // Split items, with value and weight of k units
+    vector<pair<int, int>> split;
+    vector<pair<int, int>> origin;
+    for (int i = 0; i < (int) items.size(); ++i) {
+        auto [value, weight] = items[i];
+
+        // Never more copies than fit
+        int count = counts[i];
+        if (weight > 0) {
+            count = min(count, capacity / weight);
+        }
+
+        for (int k = 1; count > 0; k *= 2) {
+            int take = min(k, count);
+            count -= take;
+
+            if ((ll) value * take > numeric_limits<int>::max()) {
+                throw overflow_error("value of split item does not fit in int");
+            }
+
+            split.push_back({value * take, weight * take});
+            origin.push_back({i, take});
+        }
+    }
+
+    vector<int> indices;
+    for (int s : cover_lean(capacity, split, threads)) {
+        for (int k = 0; k < origin[s].second; ++k) {
+            indices.push_back(origin[s].first);
+        }
+    }
+
+    sort(indices.begin(), indices.end());
+    return indices;
+}
+
+/**
+ * Solve the unbounded knapsack problem, every item may be used any number of times
+ *
+ * One row, capacity ascending so row[c - weight] may already include the
+ * item, and for every capacity the last item added to reach its best value.
+ *
+ * Time complexity: O(n * capacity)
+ * Space complexity: O(capacity)
+ *
+ * @param capacity Knapsack capacity
+ * @param items List of items with value and weight
+ * @return Indices of items used, each repeated once per copy
+ */
+vector<int> cover_unbounded(
+    int capacity,
+    const vector<pair<int, int>>& items
+) {
+    vector<ll> row(capacity + 1, 0);
+    vector<int> last(capacity + 1, -1);
+
+    for (int i = 0; i < (int) items.size(); ++i) {
+        ll value = items[i].first;
+        int weight = items[i].second;
+
+        // Weightless items could be taken endlessly
+        if (weight == 0) {
+            if (value > 0) {
+                throw invalid_argument("unbounded item with weight 0 and positive value");
+            }
+            continue;
+        }
+
+        for (int c = weight; c <= capacity; ++c) {
+            if (row[c - weight] + value > row[c]) {
+                row[c] = row[c - weight] + value;
+                last[c] = i;
+            }
+        }
+    }
+
+    // The item that set row[c], then what was best for the rest
+    vector<int> indices;
+    for (int c = capacity; c > 0 && last[c] != -1; c -= items[last[c]].second) {
+        indices.push_back(last[c]);
+    }
+
+    sort(indices.begin(), indices.end());
+    return indices;
+}
+
+/**
+ * Compare cover() and cover_lean(), then run cover_lean()
+ * where the full table would not fit in memory
+ */
+int bench()
+{
+    mt19937 rng(1);
+    bool ok = true;
+
+    auto random_items = [&](int n, int max_weight) {
+        vector<pair<int, int>> items(n);
+        for (auto & [value, weight] : items) {
+            value = rng() % 1000000;
+            weight = rng() % max_weight + 1;
+        }
+        return items;
+    };
+
+    auto total = [](const vector<pair<int, int>>& items, const vector<int>& indices) {
+        ll value = 0;
+        for (int i : indices) {
+            value += items[i].first;
+        }
+        return value;
+    };
+
+    {
+        int capacity = 20000, n = 2000;
+        auto items = random_items(n, capacity / 10);
+
+        auto start = chrono::steady_clock::now();
+        ll expected = total(items, cover(capacity, items));
+        auto end = chrono::steady_clock::now();
+        cout << "capacity " << capacity << ", " << n << " items\n";
+        cout << "  cover: " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        start = chrono::steady_clock::now();
+        ll lean = total(items, cover_lean(capacity, items));
+        end = chrono::steady_clock::now();
+        cout << "  cover_lean: " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        ok = ok && expected == lean;
+    }
+
+    // The full table here would take 4 * 10^9 cells
+    {
+        int capacity = 1000000, n = 4000;
+        int threads = thread::hardware_concurrency();
+        auto items = random_items(n, capacity / 100);
+
+        auto start = chrono::steady_clock::now();
+        vector<int> indices = cover_lean(capacity, items, threads);
+        auto end = chrono::steady_clock::now();
+        cout << "capacity " << capacity << ", " << n << " items\n";
+        cout << "  cover_lean (" << threads << " threads): "
+             << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        ll weight = 0;
+        for (int i : indices) {
+            weight += items[i].second;
+        }
+        ok = ok && weight <= capacity && total(items, indices) == best_values(capacity, items, 0, n)[capacity];
+    }
+
+    // Rows longer than DIRECT_CELLS, split down to single items
+    {
+        int capacity = 5000000, n = 8;
+        auto items = random_items(n, capacity / 2);
+
+        vector<int> indices = cover_lean(capacity, items);
+        ll weight = 0;
+        for (int i : indices) {
+            weight += items[i].second;
+        }
+        ok = ok && weight <= capacity && total(items, indices) == best_values(capacity, items, 0, n)[capacity];
+
+        indices = cover_lean(capacity, {{5, 3}, {7, 4}});
+        ok = ok && indices == vector<int>{0, 1};
+    }
+
+    // Subset sum, target 10^7 with 10^4 items
+    {
+        int target = 10000000, n = 10000;
+        vector<int> weights(n);
+        for (auto & w : weights) {
+            w = rng() % 20000 + 1;
+        }
+
+        auto start = chrono::steady_clock::now();
+        auto indices = subset_sum(target, weights);
+        auto end = chrono::steady_clock::now();
+        cout << "subset sum " << target << ", " << n << " items: "
+             << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        ll sum = 0;
+        for (int i : indices.value_or(vector<int>())) {
+            sum += weights[i];
+        }
+        ok = ok && indices && sum == target;
+    }
+
+    // Bounded and unbounded, 1000 items with up to 1000 copies each
+    {
+        int capacity = 100000, n = 1000;
+        auto items = random_items(n, capacity / 100);
+        vector<int> counts(n);
+        for (auto & c : counts) {
+            c = rng() % 1000 + 1;
+        }
+
+        auto start = chrono::steady_clock::now();
+        cover_bounded(capacity, items, counts);
+        auto end = chrono::steady_clock::now();
+        cout << "bounded, capacity " << capacity << ", " << n << " items: "
+             << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        start = chrono::steady_clock::now();
+        cover_unbounded(capacity, items);
+        end = chrono::steady_clock::now();
+        cout << "unbounded, capacity " << capacity << ", " << n << " items: "
+             << chrono::duration<double, milli>(end - start).count() << " ms\n";
+    }
+
+    cout << (ok ? "ok" : "MISMATCH") << endl;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char ** argv)
 {
     cin.sync_with_stdio(false);
     cin.tie(nullptr);
 
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
+
 
     int capacity, n;
     while (cin >> capacity >> n)
@@ -101,7 +690,7 @@ int main()
             cin >> items[i].first >> items[i].second;
         }
 
-        vector<int> result = cover(capacity, items);
+        vector<int> result = cover_lean(capacity, items);
         cout << result.size() << '\n';
         for (int i = 0; i < result.size(); ++i) {
             cout << result[i] << ' ';
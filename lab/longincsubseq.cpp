@@ -2,6 +2,13 @@
 #include <vector>
 #include <algorithm>
 #include <limits>
+#include <functional>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include "../util/bench.cpp"
 
 /**
  * @author Oskar Arensmeier
@@ -31,6 +38,11 @@
  * Complexity:
  * Time: O(n log n)
  * Space: O(n)
+ *
+ * lis() keeps the whole input in memory. IncreasingSubsequence below
+ * consumes the input in chunks, needs O(L) memory for the length and
+ * spills predecessors to disk to reconstruct; main() uses it and bench()
+ * compares it against lis().
  */
 
 #define SZ 1000000
@@ -38,6 +50,7 @@
 const int oo = std::numeric_limits<int>::max();
 
 using namespace std;
+using ll = long long;
 
 /**
  * Longest Increasing Subsequence
@@ -94,27 +107,440 @@ vector<int> lis(vector<int> const& arr) {
     return seq;
 }
 
-int main()
+/**
+ * Longest increasing subsequence over a stream of elements.
+ *
+ * Algorithm:
+ * Same patience sorting as lis(), but only the active prefix of dp is
+ * stored: tails[l] is the smallest element ending a subsequence of
+ * length l + 1, so tails has exactly L entries, where L is the length of
+ * the longest subsequence so far. Elements are pushed one chunk at a
+ * time and never need to be held together.
+ *
+ * The position of each element is found with a branchless binary search
+ * over tails only: the loop advances by the step times the comparison
+ * result instead of branching on it, so it runs a fixed log L iterations
+ * without mispredictions. An element that extends the longest subsequence
+ * is appended without searching, which is the common case on mostly
+ * sorted input.
+ *
+ * Elements are ordered by Compare. With Strict, a subsequence is
+ * increasing (comp(a, b) for consecutive a, b), otherwise non-decreasing
+ * (!comp(b, a)).
+ *
+ * To reconstruct, each element's predecessor index is recorded, which is
+ * O(n) data. It is kept in chunks of chunk_size records and every full
+ * chunk is spilled to a temporary file. Walking the predecessors back
+ * from the end visits chunks in decreasing order, so each is read back
+ * at most once.
+ *
+ * Complexity:
+ * Time: O(n log L)
+ * Space: O(L) for length only, O(L + chunk_size) memory plus O(n) disk
+ * to reconstruct
+ *
+ * Data structures:
+ * - tails: smallest ending element for each length
+ * - ends: index of the element in tails, for reconstruction
+ * - chunk and spill file: predecessor and value of every element
+ */
+template <class T, class Compare = less<T>, bool Strict = true>
+class IncreasingSubsequence {
+public:
+
+    /**
+     * @param reconstruct Record predecessors so that sequence() can be called
+     * @param chunk_size Number of predecessor records kept in memory
+     * @param comp Strict weak ordering of the elements
+     * @throws invalid_argument if reconstruct is set and T is not trivially copyable
+     */
+    IncreasingSubsequence(bool reconstruct = false, size_t chunk_size = 1 << 20, Compare comp = Compare())
+        : reconstruct(reconstruct), chunk_size(max<size_t>(chunk_size, 1)), comp(comp)
+    {
+        if (reconstruct) {
+            // Records are spilled as raw bytes
+            if (!is_trivially_copyable_v<T>) {
+                throw invalid_argument("reconstruction needs a trivially copyable element type");
+            }
+            chunk.reserve(this->chunk_size);
+        }
+    }
+
+    ~IncreasingSubsequence()
+    {
+        if (spill != nullptr) {
+            fclose(spill);
+        }
+    }
+
+    IncreasingSubsequence(const IncreasingSubsequence &) = delete;
+    IncreasingSubsequence & operator=(const IncreasingSubsequence &) = delete;
+
+    /**
+     * Add the next element of the sequence
+     */
+    void push(const T & x)
+    {
+        size_t l;
+        if (tails.empty() || before(tails.back(), x)) {
+            l = tails.size();
+            tails.push_back(x);
+        } else {
+            l = position(x);
+            tails[l] = x;
+        }
+
+        if (reconstruct) {
+            record(l, x);
+        }
+
+        ++count;
+    }
+
+    /**
+     * Add the next elements of the sequence
+     */
+    template <class It>
+    void push(It first, It last)
+    {
+        for (; first != last; ++first) {
+            push(*first);
+        }
+    }
+
+    /**
+     * Length of the longest subsequence of the elements pushed so far
+     */
+    size_t length() const
+    {
+        return tails.size();
+    }
+
+    /**
+     * Number of elements pushed so far
+     */
+    ll size() const
+    {
+        return count;
+    }
+
+    /**
+     * A longest subsequence of the elements pushed so far
+     *
+     * @return Index and value of each element, in order
+     * @throws logic_error if constructed without reconstruct
+     */
+    vector<pair<ll, T>> sequence()
+    {
+        if (!reconstruct) {
+            throw logic_error("sequence() needs reconstruct");
+        }
+
+        vector<pair<ll, T>> seq(tails.size());
+        vector<Node> buffer;
+        ll loaded = -1;
+
+        ll i = ends.empty() ? -1 : ends.back();
+        for (size_t k = seq.size(); k-- > 0;) {
+            const Node * node;
+            if (i >= spilled) {
+                node = &chunk[i - spilled];
+            } else {
+                ll c = i / (ll) chunk_size;
+                if (c != loaded) {
+                    load(c, buffer);
+                    loaded = c;
+                }
+                node = &buffer[i - c * (ll) chunk_size];
+            }
+
+            seq[k] = {i, node->value};
+            i = node->prev;
+        }
+
+        return seq;
+    }
+
+private:
+
+    struct Node {
+        ll prev;
+        T value;
+    };
+
+    /** Record predecessors */
+    bool reconstruct;
+
+    /** Records kept in memory before spilling */
+    size_t chunk_size;
+
+    /** Element ordering */
+    Compare comp;
+
+    /** tails[l] = smallest element ending a subsequence of length l + 1 */
+    vector<T> tails;
+
+    /** ends[l] = index of tails[l] */
+    vector<ll> ends;
+
+    /** Records of elements [spilled, count) */
+    vector<Node> chunk;
+
+    /** Records of elements [0, spilled), nullptr until the first spill */
+    FILE * spill = nullptr;
+
+    /** Number of spilled records, a multiple of chunk_size */
+    ll spilled = 0;
+
+    /** Number of elements pushed */
+    ll count = 0;
+
+    /**
+     * Whether a may come directly before b in a subsequence
+     */
+    bool before(const T & a, const T & b) const
+    {
+        if constexpr (Strict) {
+            return comp(a, b);
+        } else {
+            return !comp(b, a);
+        }
+    }
+
+    /**
+     * Number of tails that may come before x, which is the length of
+     * the longest subsequence x can extend
+     */
+    size_t position(const T & x) const
+    {
+        const T * base = tails.data();
+        size_t len = tails.size();
+
+        while (len > 1) {
+            size_t half = len / 2;
+            // Multiply, a ternary here compiles to a branch
+            base += half * before(base[half - 1], x);
+            len -= half;
+        }
+
+        return (base - tails.data()) + before(*base, x);
+    }
+
+    /**
+     * Store the predecessor of element count, which ends a subsequence
+     * of length l + 1
+     */
+    void record(size_t l, const T & x)
+    {
+        if (l == ends.size()) {
+            ends.push_back(count);
+        } else {
+            ends[l] = count;
+        }
+
+        chunk.push_back({l > 0 ? ends[l - 1] : -1, x});
+
+        if (chunk.size() == chunk_size) {
+            if (spill == nullptr && (spill = tmpfile()) == nullptr) {
+                throw runtime_error("Could not create spill file");
+            }
+
+            if (fwrite(chunk.data(), sizeof(Node), chunk.size(), spill) != chunk.size()) {
+                throw runtime_error("Could not write spill file");
+            }
+
+            spilled += chunk.size();
+            chunk.clear();
+        }
+    }
+
+    /**
+     * Read spilled chunk c into buffer
+     */
+    void load(ll c, vector<Node> & buffer)
+    {
+        buffer.resize(chunk_size);
+
+        if (fseeko(spill, (off_t) (c * (ll) chunk_size * sizeof(Node)), SEEK_SET) != 0
+            || fread(buffer.data(), sizeof(Node), chunk_size, spill) != chunk_size) {
+            throw runtime_error("Could not read spill file");
+        }
+
+        // Later writes append at the end
+        fseeko(spill, 0, SEEK_END);
+    }
+};
+
+/**
+ * Read count integers from in and pass them on in chunks
+ *
+ * @param fn Called as fn(first, last) for each chunk
+ * @return Number of integers read
+ */
+template <class F>
+ll read_chunks(istream & in, ll count, F fn)
+{
+    const size_t CHUNK = 1 << 16;
+
+    vector<int> buf(CHUNK);
+    ll done = 0;
+
+    while (done < count) {
+        size_t len = min<ll>(CHUNK, count - done);
+        size_t got = 0;
+        while (got < len && in >> buf[got]) {
+            ++got;
+        }
+
+        fn(buf.begin(), buf.begin() + got);
+        done += got;
+
+        if (got < len) {
+            break;
+        }
+    }
+
+    return done;
+}
+
+/**
+ * Check IncreasingSubsequence<int, Compare, Strict> on arr against an
+ * O(n^2) brute force, reconstructing through chunks of chunk_size
+ *
+ * @return True if the length matches and the sequence is valid
+ */
+template <class Compare, bool Strict>
+bool check_variant(const vector<int> & arr, size_t chunk_size, Compare comp = Compare())
+{
+    auto before = [&](int a, int b) {
+        return Strict ? comp(a, b) : !comp(b, a);
+    };
+
+    // best[i] = longest subsequence ending at arr[i]
+    int n = arr.size();
+    vector<size_t> best(n, 1);
+    size_t length = 0;
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < i; ++j) {
+            if (before(arr[j], arr[i])) {
+                best[i] = max(best[i], best[j] + 1);
+            }
+        }
+        length = max(length, best[i]);
+    }
+
+    IncreasingSubsequence<int, Compare, Strict> lis(true, chunk_size, comp);
+    lis.push(arr.begin(), arr.end());
+    vector<pair<ll, int>> seq = lis.sequence();
+
+    bool ok = lis.length() == length && seq.size() == length;
+    for (size_t k = 0; ok && k < seq.size(); ++k) {
+        ok = arr[seq[k].first] == seq[k].second && (k == 0 || (seq[k - 1].first < seq[k].first && before(seq[k - 1].second, seq[k].second)));
+    }
+
+    return ok;
+}
+
+/**
+ * Time lis() against IncreasingSubsequence on random and mostly sorted
+ * input, checking that the lengths agree and that the reconstructed
+ * sequence is increasing. The non-strict and custom comparator variants
+ * are checked against a brute force on small inputs with tiny chunks.
+ */
+int bench()
+{
+    mt19937 rng(1);
+    bool ok = true;
+
+    for (int n : {1000000, 30000000}) {
+        for (int sorted : {0, 1}) {
+            vector<int> arr(n);
+            for (int i = 0; i < n; ++i) {
+                arr[i] = sorted ? i + (int) (rng() % 1000) : (int) (rng() % 1000000000);
+            }
+
+            cout << "n = " << n << (sorted ? ", mostly sorted\n" : ", random\n");
+
+            vector<int> ref;
+            double t = Bench::time([&] { ref = lis(arr); });
+            cout << "  lis(): " << t << " ms\n";
+
+            IncreasingSubsequence<int> len_only;
+            t = Bench::time([&] { len_only.push(arr.begin(), arr.end()); });
+            cout << "  length only: " << t << " ms\n";
+
+            // Small chunks to exercise spilling
+            IncreasingSubsequence<int> full(true, 1 << 18);
+            vector<pair<ll, int>> seq;
+            t = Bench::time([&] {
+                full.push(arr.begin(), arr.end());
+                seq = full.sequence();
+            });
+            cout << "  reconstruct: " << t << " ms\n";
+            cout << "  length: " << len_only.length() << "\n";
+
+            ok = ok && len_only.length() == ref.size() && seq.size() == ref.size();
+            for (size_t k = 0; ok && k < seq.size(); ++k) {
+                ok = arr[seq[k].first] == seq[k].second && (k == 0 || (seq[k - 1].first < seq[k].first && seq[k - 1].second < seq[k].second));
+            }
+        }
+    }
+
+    // Few distinct values so that ties matter, chunks of a
+    // handful of records so that every sequence spills
+    struct ByTens {
+        bool operator()(int a, int b) const {
+            return a / 10 < b / 10;
+        }
+    };
+
+    int checks = 0;
+    for (int i = 0; i < 2000 && ok; ++i) {
+        vector<int> arr(rng() % 60);
+        for (int & x : arr) {
+            x = rng() % 40;
+        }
+        size_t chunk = 1 + rng() % 5;
+
+        ok = check_variant<less<int>, true>(arr, chunk)
+            && check_variant<less<int>, false>(arr, chunk)
+            && check_variant<greater<int>, true>(arr, chunk)
+            && check_variant<greater<int>, false>(arr, chunk)
+            && check_variant<ByTens, true>(arr, chunk)
+            && check_variant<ByTens, false>(arr, chunk)
+            && check_variant<function<bool(int, int)>, true>(arr, chunk, [](int a, int b) { return a % 7 < b % 7; });
+        checks += ok;
+    }
+    cout << "variants vs brute force: " << checks << " inputs\n";
+
+    return Bench::report(ok);
+}
+
+int main(int argc, char ** argv)
 {
     cin.sync_with_stdio(false);
     cin.tie(nullptr);
 
-    int N;
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
+
+    ll N;
     while (cin >> N) {
 
-        vector<int> arr(N);
-        for (int i = 0; i < N; i++) {
-            cin >> arr[i];
-        }
+        IncreasingSubsequence<int> lis(true);
+        read_chunks(cin, N, [&](auto first, auto last) {
+            lis.push(first, last);
+        });
 
-        vector<int> seq = lis(arr);
+        vector<pair<ll, int>> seq = lis.sequence();
         cout << seq.size() << '\n';
-        for (int i = 0; i < seq.size(); i++) {
-            cout << seq[i] << ' ';
+        for (size_t i = 0; i < seq.size(); i++) {
+            cout << seq[i].first << ' ';
         }
         cout << '\n';
    }
 
     cout << flush;
     return 0;
-}
\ No newline at end of file
+}
@@ -2,7 +2,13 @@
 #include <vector>
 #include <limits>
 #include <queue>
-#include "../util/bellmanford.cpp"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <functional>
+#include <chrono>
+#include <random>
+#include <stdexcept>
 
 /**
  * @author Oskar Arensmeier
@@ -11,7 +17,7 @@
 
 /**
  * Implementation of successive shortest path for
- * multi graphs using potentials (through Bellman-Ford) to
+ * multi graphs using potentials (through SPFA / Bellman-Ford) to
  * allow for dijkstra to be used. Solves min cost max flow.
  *
  * Algorithm:
@@ -30,20 +36,26 @@
  *
  * Init
  * 1. Create residual (multi) graph from the original edges.
- * 2. Run Bellman-Ford to compute inital potentials.
+ * 2. Compute inital potentials, see compute_potentials:
+ *    - All costs non-negative: zero potentials are already valid
+ *    - Acyclic graph: one relaxation pass in topological order
+ *    - Otherwise: SPFA (queue based Bellman-Ford), which only revisits
+ *      nodes whose distance changed and stops as soon as nothing does
+ *    Distances are taken from a virtual root joined to every node, so a
+ *    negative cycle anywhere in the graph is rejected
  *
  * Core loop
  * 3. While a dijkstra returns a shortest path:
  *    (If no path, break)
  * 4. Find max flow along that path
- * 5. Adjust residual graph capacities and flow matrix
+ * 5. Adjust residual graph capacities
  * 6. Update total flow and cost
  * 7. Update potentials by adding the new distances from dijkstra
  *   (This ensures dijkstra can be run again)
  * 8. Repeat from step 3.
  *
  * Time complexity:
- * - O(m * n) Pre-processing (running Bellman-Ford)
+ * - O(m * n) Pre-processing (SPFA worst case, O(m) for non-negative or acyclic)
  * - O(F * m * log(n)) For the core algorithm (we may run dijkstra F times)
  *
  * Total: O(m * n + F * m * log(n))
@@ -51,17 +63,29 @@
  * Where n is nodes, m is edges and F is the maximum flow.
  *
  * Space complexity:
- * - O(m) for the adjacency list
+ * - O(m) for the residual graph
  * - O(n) for the distance, parent and potential arrays
- * - O(n^2) for the flow matrix
+ * - O(m) for the flow per edge
  * 
- * Total: O(m + n + n^2) = O(m + n^2)
+ * Total: O(n + m)
  *
  * Where n is nodes and m is edges.
  * 
  * Data structures:
- * - Adjacency list using vectors
+ * - Flat (CSR) residual edge store, see ResidualGraph
  * - Vectors for the distance, parent and potential arrays
+ *
+ * Other engines:
+ *
+ * SSP is slow when capacities are large since F may be huge. Two more
+ * engines share the same residual edge store:
+ * - SSP::capacity_scaling, O(m * log(U)) augmentations of delta units each
+ * - CostScaling, Goldberg-Tarjan push-relabel, O(n^2 * m * log(n * C))
+ * Both return the same Result (64-bit flow and cost, flow per edge), and
+ * all three throw std::runtime_error on a negative cycle, reachable from
+ * the source or not.
+ * Run with 'bench' as the first argument to compare all engines on
+ * generated grid and transportation instances.
  */
 
 /* Answers - Complementary work 
@@ -136,61 +160,332 @@ public:
  */
 using EdgeList = vector<Edge>;
 
+/**
+ * Flat residual edge store shared by all engines
+ *
+ * Arcs of node u are [offset[u], offset[u+1]) in the flat arrays.
+ * Each original edge owns one forward arc and a paired reverse
+ * arc (cost negated, no capacity).
+ */
+class ResidualGraph {
+public:
+    /**
+     * Node count
+     */
+    int n;
+
+    /**
+     * Arcs of node u are [offset[u], offset[u+1])
+     */
+    vector<int> offset;
+
+    /**
+     * Target node of each arc
+     */
+    vector<int> to;
+
+    /**
+     * Index of the paired reverse arc
+     */
+    vector<int> rev;
+
+    /**
+     * Cost of each arc
+     */
+    vector<ll> cost;
+
+    /**
+     * Residual capacity of each arc
+     */
+    vector<ll> cap;
+
+    /**
+     * Forward arc of each original edge
+     */
+    vector<int> edge_arc;
+
+    /**
+     * Original capacity of each edge
+     */
+    vector<ll> capacity;
+
+    /**
+     * Constructor
+     *
+     * @param n Number of nodes
+     * @param edges List of edges
+     */
+    ResidualGraph(int n, const EdgeList & edges) : n(n)
+    {
+        int m = edges.size();
+
+        offset.assign(n + 1, 0);
+        for (auto & e : edges) {
+            offset[e.u + 1]++;
+            offset[e.v + 1]++;
+        }
+
+        for (int u = 0; u < n; ++u) {
+            offset[u + 1] += offset[u];
+        }
+
+        to.resize(2 * m);
+        rev.resize(2 * m);
+        cost.resize(2 * m);
+        cap.resize(2 * m);
+        edge_arc.resize(m);
+        capacity.resize(m);
+
+        vector<int> pos(offset.begin(), offset.end() - 1);
+        for (int i = 0; i < m; ++i) {
+            auto & e = edges[i];
+            int a = pos[e.u]++;
+            int b = pos[e.v]++;
+
+            to[a] = e.v;
+            to[b] = e.u;
+            rev[a] = b;
+            rev[b] = a;
+            cost[a] = e.cost;
+            cost[b] = -e.cost;
+
+            edge_arc[i] = a;
+            capacity[i] = e.cap;
+        }
+
+        reset();
+    }
+
+    /**
+     * Restore residual capacities to zero flow
+     */
+    void reset()
+    {
+        fill(cap.begin(), cap.end(), 0);
+        for (int i = 0; i < edge_arc.size(); ++i) {
+            cap[edge_arc[i]] = capacity[i];
+        }
+    }
+
+    /**
+     * Push flow along an arc
+     */
+    void push(int a, ll f)
+    {
+        cap[a] -= f;
+        cap[rev[a]] += f;
+    }
+
+    /**
+     * Source node of an arc
+     */
+    int from(int a) const
+    {
+        return to[rev[a]];
+    }
+
+    /**
+     * Current flow on every original edge
+     */
+    vector<ll> edge_flow() const
+    {
+        vector<ll> f(edge_arc.size());
+        for (int i = 0; i < edge_arc.size(); ++i) {
+            f[i] = capacity[i] - cap[edge_arc[i]];
+        }
+
+        return f;
+    }
+
+    /**
+     * Total cost of the current flow
+     */
+    ll flow_cost() const
+    {
+        ll total = 0;
+        for (int i = 0; i < edge_arc.size(); ++i) {
+            int a = edge_arc[i];
+            total += (capacity[i] - cap[a]) * cost[a];
+        }
+
+        return total;
+    }
+
+    /**
+     * Largest original capacity
+     */
+    ll max_capacity() const
+    {
+        ll c = 0;
+        for (ll x : capacity) {
+            c = max(c, x);
+        }
+
+        return c;
+    }
+
+    /**
+     * Shortest distances from a virtual root with a zero cost arc
+     * to every node, over the arcs with capacity (SPFA). Only nodes
+     * whose distance changed are queued, so it stops as soon as a
+     * pass would change nothing.
+     *
+     * Starting from every node finds negative cycles anywhere in
+     * the graph, not just those reachable from the source, so all
+     * engines reject the same inputs.
+     *
+     * @return Distances, valid potentials for every arc with capacity
+     * @throws std::runtime_error if there is a negative cycle
+     */
+    vector<ll> root_distances() const
+    {
+        vector<ll> dist(n, 0);
+        vector<int> length(n, 0); // Arcs on current shortest path
+        vector<bool> queued(n, true);
+
+        queue<int> q;
+        for (int u = 0; u < n; ++u) {
+            q.push(u);
+        }
+
+        while (! q.empty()) {
+            int u = q.front();
+            q.pop();
+            queued[u] = false;
+
+            for (int a = offset[u]; a < offset[u + 1]; ++a) {
+                int v = to[a];
+                if (cap[a] == 0 || dist[u] + cost[a] >= dist[v]) {
+                    continue;
+                }
+
+                dist[v] = dist[u] + cost[a];
+                length[v] = length[u] + 1;
+
+                // A shortest path can not have n arcs
+                if (length[v] >= n) {
+                    throw std::runtime_error("Negative cycle");
+                }
+
+                if (! queued[v]) {
+                    q.push(v);
+                    queued[v] = true;
+                }
+            }
+        }
+
+        return dist;
+    }
+
+    /**
+     * Max flow (Dinic) on the current residual capacities,
+     * ignoring costs. Used by the scaling engines to find
+     * how much flow to route.
+     *
+     * @param src Source
+     * @param sink Sink
+     * @param limit Max flow to push
+     * @return Flow pushed
+     */
+    ll max_flow(int src, int sink, ll limit)
+    {
+        vector<int> level(n);
+        vector<int> it(n);
+
+        ll flow = 0;
+        while (flow < limit) {
+            fill(level.begin(), level.end(), -1);
+            level[src] = 0;
+
+            queue<int> q;
+            q.push(src);
+            while (! q.empty()) {
+                int u = q.front();
+                q.pop();
+
+                for (int a = offset[u]; a < offset[u + 1]; ++a) {
+                    if (cap[a] > 0 && level[to[a]] == -1) {
+                        level[to[a]] = level[u] + 1;
+                        q.push(to[a]);
+                    }
+                }
+            }
+
+            if (level[sink] == -1) {
+                break;
+            }
+
+            for (int u = 0; u < n; ++u) {
+                it[u] = offset[u];
+            }
+
+            while (flow < limit) {
+                ll f = blocking_flow(src, sink, limit - flow, level, it);
+                if (f == 0) {
+                    break;
+                }
+
+                flow += f;
+            }
+        }
+
+        return flow;
+    }
+
+private:
+    /**
+     * DFS along the level graph using current-arc pointers
+     */
+    ll blocking_flow(int u, int sink, ll pushed, vector<int> & level, vector<int> & it)
+    {
+        if (u == sink) {
+            return pushed;
+        }
+
+        for (int & a = it[u]; a < offset[u + 1]; ++a) {
+            int v = to[a];
+            if (cap[a] == 0 || level[v] != level[u] + 1) {
+                continue;
+            }
+
+            ll f = blocking_flow(v, sink, min(pushed, cap[a]), level, it);
+            if (f > 0) {
+                push(a, f);
+                return f;
+            }
+        }
+
+        return 0;
+    }
+};
+
+/**
+ * Result of running a min cost flow engine
+ */
+class Result {
+public:
+    /**
+     * Flow
+     */
+    ll flow;
+
+    /**
+     * Cost
+     */
+    ll cost;
+
+    /**
+     * Flow per original edge
+     */
+    vector<ll> edge_flow;
+};
+
 /**
  * Successive shortest path algorithm
  */
 class SSP {
 
 public:
-    class ResidualEdge {
-    public:
-        /**
-         * Target node
-         */
-        int to;
-
-        /**
-         * Index in adjacency list
-         * of the reverse edge
-         */
-        int rev_idx;
-
-        /**
-         * Cost
-         */
-        int cost;
-
-        /**
-         * Capacity
-         */
-        int cap;
-
-        ResidualEdge(int to, int rev_idx, int cost, int cap) :
-            to(to), rev_idx(rev_idx), cost(cost), cap(cap)
-        {}
-    };
-
-    /**
-     * Result of running the algorithm
-     */
-    class Result {
-    public:
-        /**
-         * Flow
-         */
-        int flow;
-
-        /**
-         * Cost
-         */
-        int cost;
-
-        /**
-         * Flow matrix
-         */
-        vector<vector<int>> flow_graph;
-    };
-
     /**
      * Edges
      */
@@ -201,13 +496,18 @@ public:
      */
     int n;
 
+    /**
+     * Residual graph
+     */
+    ResidualGraph g;
+
     /**
      * Constructor
      *
      * @param n Number of nodes
      * @param edges List of edges
      */
-    SSP(int n, EdgeList edges) : n(n), edges(edges)
+    SSP(int n, EdgeList edges) : n(n), edges(edges), g(n, this->edges)
     {}
 
     /**
@@ -216,42 +516,31 @@ public:
      * @param src Source
      * @param sink Sink
      * @param K Limit flow - default INF, for max flow
-     * @return {flow, cost, flow matrix}
+     * @return {flow, cost, flow per edge}
+     * @throws std::runtime_error if there is a negative cycle
      */
     Result min_cost_max_flow(
         int src,
         int sink,
-        int K = numeric_limits<int>::max()
+        ll K = INF
     ) {
-        // Multi graph adjacency list of original
-        // and residual edges
-        vector<vector<ResidualEdge>> adj(n);
+        g.reset();
 
-        for (auto & e : edges) {
-            int u_idx = adj[e.u].size();
-            int v_idx = adj[e.v].size();
+        /*
+        parent[v] = arc used to reach v.
 
-            adj[e.u].emplace_back(e.v, v_idx, e.cost, e.cap);
-            adj[e.v].emplace_back(e.u, u_idx, -e.cost, 0);
-        }
-
-        /* 
-        parent[v] = {u, idx},
-        Where adj[v][idx] = parent edge of v.
-        
         This is important since the graph is a multi graph,
         and we need to know exactly which edge was used by dijkstra.
         */
-        vector<pair<int, int>> parent;
+        vector<int> parent;
 
         vector<ll> dist;
-        vector<vector<int>> flow(n, vector<int>(n, 0)); // Flow matrix
-        vector<ll> potentials = compute_potentials(src, adj);
+        vector<ll> potentials = compute_potentials();
 
-        int total_flow = 0;
-        int total_cost = 0;
+        ll total_flow = 0;
+        ll total_cost = 0;
         while (total_flow < K) {
-            dijkstra(src, adj, dist, parent, potentials);
+            dijkstra(src, dist, parent, potentials);
 
             // Check if no shortest path
             if (dist[sink] == INF) {
@@ -270,41 +559,163 @@ public:
             }
 
             // Find max flow on shortest path
-            int f = K - total_flow;
-            int curr = sink;
-            while (curr != src) {
-                int prev = parent[curr].first;
-                int idx = parent[curr].second;
-
-                f = min(f, adj[prev][idx].cap);
-                curr = prev;
+            ll f = K - total_flow;
+            for (int curr = sink; curr != src; curr = g.from(parent[curr])) {
+                f = min(f, g.cap[parent[curr]]);
             }
 
             total_flow += f;
 
             // Adjust capacities according to
             // altered flow
-            curr = sink;
-            while (curr != src) {
-                int prev = parent[curr].first;
-                int idx = parent[curr].second;
-                int idx_rev = adj[prev][idx].rev_idx;
+            for (int curr = sink; curr != src; curr = g.from(parent[curr])) {
+                int a = parent[curr];
+                g.push(a, f);
+                total_cost += f * g.cost[a];
+            }
+        }
+
+        return {total_flow, total_cost, g.edge_flow()};
+    }
+
+    /**
+     * Minimum cost maximum flow using capacity scaling
+     *
+     * First finds how much flow to route (max flow, capped by K),
+     * then routes it as a min cost flow with supply at src and
+     * demand at sink. Phase delta only considers arcs with at least
+     * delta residual capacity, and every augmentation moves exactly
+     * delta units, so there are O(m) augmentations per phase and
+     * O(log U) phases instead of one Dijkstra per unit of path capacity.
+     *
+     * Arcs with negative reduced cost are saturated at the start of
+     * each phase, so arbitrary (non negative cycle) costs are fine
+     * and potentials start at zero. Negative cycles are rejected up
+     * front like in min_cost_max_flow(), saturating them would
+     * otherwise give a cheaper answer than SSP.
+     *
+     * Time: O(m * log(U) * (n + m) * log(n)), U max capacity
+     *
+     * @param src Source
+     * @param sink Sink
+     * @param K Limit flow - default INF, for max flow
+     * @return {flow, cost, flow per edge}
+     * @throws std::runtime_error if there is a negative cycle
+     */
+    Result capacity_scaling(
+        int src,
+        int sink,
+        ll K = INF
+    ) {
+        g.reset();
+        g.root_distances();
 
-                // Adjust capacities
-                adj[prev][idx].cap -= f;
-                adj[curr][idx_rev].cap += f;
+        ll total_flow = g.max_flow(src, sink, K);
+        g.reset();
 
-                // Adjust flows
-                flow[prev][curr] += f;
-                flow[curr][prev] = max(flow[curr][prev] - f, 0);
+        vector<ll> excess(n, 0);
+        excess[src] += total_flow;
+        excess[sink] -= total_flow;
+
+        vector<ll> potentials(n, 0);
+        vector<ll> dist(n);
+        vector<int> parent(n);
+        vector<bool> done(n);
+
+        ll delta = 1;
+        while (delta * 2 <= max(g.max_capacity(), total_flow)) {
+            delta *= 2;
+        }
 
-                total_cost += f * adj[prev][idx].cost;
+        for (; delta >= 1; delta /= 2) {
 
-                curr = prev;
+            // Restore optimality for the delta-residual graph
+            for (int u = 0; u < n; ++u) {
+                for (int a = g.offset[u]; a < g.offset[u + 1]; ++a) {
+                    int v = g.to[a];
+                    if (g.cap[a] < delta || g.cost[a] + potentials[u] - potentials[v] >= 0) {
+                        continue;
+                    }
+
+                    ll f = g.cap[a];
+                    g.push(a, f);
+                    excess[u] -= f;
+                    excess[v] += f;
+                }
+            }
+
+            while (true) {
+                // Multi source dijkstra from all nodes with excess >= delta,
+                // stopping at the first node with deficit <= -delta
+                fill(dist.begin(), dist.end(), INF);
+                fill(done.begin(), done.end(), false);
+
+                priority_queue<
+                    pair<ll, int>,
+                    vector<pair<ll, int>>,
+                    greater<pair<ll, int>>
+                > pq;
+
+                for (int u = 0; u < n; ++u) {
+                    if (excess[u] >= delta) {
+                        dist[u] = 0;
+                        parent[u] = -1;
+                        pq.push({0, u});
+                    }
+                }
+
+                int target = -1;
+                while (! pq.empty()) {
+                    auto [d, u] = pq.top();
+                    pq.pop();
+
+                    if (done[u]) {
+                        continue;
+                    }
+                    done[u] = true;
+
+                    if (excess[u] <= -delta) {
+                        target = u;
+                        break;
+                    }
+
+                    for (int a = g.offset[u]; a < g.offset[u + 1]; ++a) {
+                        int v = g.to[a];
+                        if (g.cap[a] < delta) {
+                            continue;
+                        }
+
+                        ll alt = d + g.cost[a] + potentials[u] - potentials[v];
+                        if (alt < dist[v]) {
+                            dist[v] = alt;
+                            parent[v] = a;
+                            pq.push({alt, v});
+                        }
+                    }
+                }
+
+                if (target == -1) {
+                    break;
+                }
+
+                // Nodes not settled are at least as far as the target
+                ll d_target = dist[target];
+                for (int u = 0; u < n; ++u) {
+                    potentials[u] += done[u] ? dist[u] : d_target;
+                }
+
+                int curr = target;
+                while (parent[curr] != -1) {
+                    g.push(parent[curr], delta);
+                    curr = g.from(parent[curr]);
+                }
+
+                excess[curr] -= delta;
+                excess[target] += delta;
             }
         }
 
-        return {total_flow, total_cost, move(flow)};
+        return {total_flow, g.flow_cost(), g.edge_flow()};
     }
 
 private:
@@ -312,20 +723,18 @@ private:
      * Dijkstra algorithm
      *
      * @param src Source node
-     * @param adj Adjacency list
      * @param dist Distance array
-     * @param parent Parent array
+     * @param parent Parent arc array
      * @param potentials Potentials
      */
     void dijkstra(
         int src,
-        vector<vector<ResidualEdge>> & adj,
         vector<ll> & dist,
-        vector<pair<int, int>> & parent,
+        vector<int> & parent,
         vector<ll> & potentials
     ) {
         dist.assign(n, INF);
-        parent.assign(n, {-1, -1});
+        parent.assign(n, -1);
 
         dist[src] = 0;
 
@@ -345,53 +754,442 @@ private:
                 continue;
             }
 
-            for (int i = 0; i < adj[u].size(); ++i) {
-                auto & e = adj[u][i];
+            for (int a = g.offset[u]; a < g.offset[u + 1]; ++a) {
+                int v = g.to[a];
 
-                if (e.cap <= 0) {
+                if (g.cap[a] <= 0) {
                     continue;
                 }
 
-                ll alt = dist[u] + ((ll) e.cost) + potentials[u] - potentials[e.to];
-                if (alt >= dist[e.to]) {
+                ll alt = dist[u] + g.cost[a] + potentials[u] - potentials[v];
+                if (alt >= dist[v]) {
                     continue;
                 }
 
-                dist[e.to] = alt;
-                parent[e.to] = {u, i};
-                pq.push({alt, e.to});
+                dist[v] = alt;
+                parent[v] = a;
+                pq.push({alt, v});
             }
         }
     }
 
     /**
      * Compute potentials for the dijkstra algorithm
-     * using Bellman-Ford.
-     * 
-     * @param adj Adjacency list
+     * directly on the residual arcs with capacity,
+     * as distances from a virtual root joined to every node.
+     *
      * @return Potentials
+     * @throws std::runtime_error if there is a negative cycle
+     */
+    vector<ll> compute_potentials() {
+        bool negative = false;
+        for (int a = 0; a < g.to.size(); ++a) {
+            if (g.cap[a] > 0 && g.cost[a] < 0) {
+                negative = true;
+                break;
+            }
+        }
+
+        // Reduced costs equal costs, already non-negative
+        if (! negative) {
+            return vector<ll>(n, 0);
+        }
+
+        vector<int> order = topological_order();
+        if (order.size() == n) {
+            return dag_potentials(order);
+        }
+
+        return g.root_distances();
+    }
+
+    /**
+     * Topological order (Kahn) of the arcs with capacity
+     *
+     * @return Order, shorter than n if there is a cycle
      */
-    vector<ll> compute_potentials(
+    vector<int> topological_order() {
+        vector<int> indegree(n, 0);
+        for (int a = 0; a < g.to.size(); ++a) {
+            if (g.cap[a] > 0) {
+                indegree[g.to[a]]++;
+            }
+        }
+
+        vector<int> order;
+        order.reserve(n);
+        for (int u = 0; u < n; ++u) {
+            if (indegree[u] == 0) {
+                order.push_back(u);
+            }
+        }
+
+        for (int i = 0; i < order.size(); ++i) {
+            int u = order[i];
+            for (int a = g.offset[u]; a < g.offset[u + 1]; ++a) {
+                if (g.cap[a] > 0 && --indegree[g.to[a]] == 0) {
+                    order.push_back(g.to[a]);
+                }
+            }
+        }
+
+        return order;
+    }
+
+    /**
+     * Shortest distances from the virtual root in an acyclic
+     * graph, single relaxation pass in topological order
+     */
+    vector<ll> dag_potentials(const vector<int> & order) {
+        vector<ll> dist(n, 0);
+
+        for (int u : order) {
+            for (int a = g.offset[u]; a < g.offset[u + 1]; ++a) {
+                if (g.cap[a] > 0) {
+                    dist[g.to[a]] = min(dist[g.to[a]], dist[u] + g.cost[a]);
+                }
+            }
+        }
+
+        return dist;
+    }
+};
+
+/**
+ * Cost scaling (Goldberg-Tarjan) min cost flow
+ * reference: A. V. Goldberg, R. E. Tarjan, "Finding minimum-cost
+ * circulations by successive approximation", 1990
+ *
+ * Costs are multiplied by (n + 1) so that an epsilon-optimal flow
+ * with epsilon = 1 is optimal for the original costs. Starting from
+ * epsilon = max |cost|, each refine step divides epsilon by ALPHA:
+ *
+ * 1. Saturate every residual arc with negative reduced cost,
+ *    which makes the pseudoflow 0-optimal but creates excesses.
+ * 2. Discharge nodes with excess (FIFO) by pushing along admissible
+ *    arcs (reduced cost < 0), relabelling a node to
+ *    max(p[v] - c(u, v)) - epsilon when none is left.
+ *
+ * The amount of flow to route is found up front with a max flow,
+ * so the engine solves a min cost flow with supply at src and demand
+ * at sink, and negative costs need no special treatment. Negative
+ * cycles are rejected up front, as in SSP.
+ *
+ * Time: O(n^2 * m * log(n * C)), C max |cost|
+ * Space: O(n + m)
+ */
+class CostScaling {
+public:
+    /**
+     * Scaling factor of epsilon per refine step
+     */
+    static constexpr ll ALPHA = 8;
+
+    /**
+     * Node count
+     */
+    int n;
+
+    /**
+     * Residual graph
+     */
+    ResidualGraph g;
+
+    /**
+     * Constructor
+     *
+     * @param n Number of nodes
+     * @param edges List of edges
+     */
+    CostScaling(int n, const EdgeList & edges) : n(n), g(n, edges)
+    {}
+
+    /**
+     * Minimum cost maximum flow
+     *
+     * @param src Source
+     * @param sink Sink
+     * @param K Limit flow - default INF, for max flow
+     * @return {flow, cost, flow per edge}
+     * @throws std::runtime_error if there is a negative cycle
+     */
+    Result min_cost_max_flow(
         int src,
-        vector<vector<ResidualEdge>> & adj
+        int sink,
+        ll K = INF
     ) {
-        BellmanFord::Graph graph(n, edges.size());
-        for (auto & e : edges) {
-            graph.add_edge(e.u, e.v, e.cost);
+        g.reset();
+        g.root_distances();
+
+        ll total_flow = g.max_flow(src, sink, K);
+        g.reset();
+
+        excess.assign(n, 0);
+        price.assign(n, 0);
+        it.resize(n);
+        excess[src] += total_flow;
+        excess[sink] -= total_flow;
+
+        ll eps = 1;
+        for (ll c : g.cost) {
+            eps = max(eps, abs(c) * (n + 1));
         }
 
-        BellmanFord::BellmanFord bf(move(graph), src);
-        bf.run();
+        while (true) {
+            eps = max(1LL, eps / ALPHA);
+            refine(eps);
 
-        return bf.dist;
+            if (eps == 1) {
+                break;
+            }
+        }
+
+        return {total_flow, g.flow_cost(), g.edge_flow()};
+    }
+
+private:
+    /**
+     * Excess of each node
+     */
+    vector<ll> excess;
+
+    /**
+     * Price (potential) of each node
+     */
+    vector<ll> price;
+
+    /**
+     * Current arc of each node
+     */
+    vector<int> it;
+
+    /**
+     * Reduced (scaled) cost of an arc
+     */
+    ll reduced_cost(int a) const
+    {
+        return g.cost[a] * (n + 1) + price[g.from(a)] - price[g.to[a]];
+    }
+
+    /**
+     * Turn a 0-optimal pseudoflow into an eps-optimal flow
+     */
+    void refine(ll eps)
+    {
+        queue<int> active;
+
+        // Saturate arcs with negative reduced cost
+        for (int u = 0; u < n; ++u) {
+            for (int a = g.offset[u]; a < g.offset[u + 1]; ++a) {
+                if (g.cap[a] == 0 || reduced_cost(a) >= 0) {
+                    continue;
+                }
+
+                ll f = g.cap[a];
+                g.push(a, f);
+                excess[u] -= f;
+                excess[g.to[a]] += f;
+            }
+        }
+
+        for (int u = 0; u < n; ++u) {
+            it[u] = g.offset[u];
+            if (excess[u] > 0) {
+                active.push(u);
+            }
+        }
+
+        while (! active.empty()) {
+            int u = active.front();
+            active.pop();
+
+            // Discharge u
+            while (excess[u] > 0) {
+                if (it[u] == g.offset[u + 1]) {
+                    relabel(u, eps);
+                    continue;
+                }
+
+                int a = it[u];
+                if (g.cap[a] == 0 || reduced_cost(a) >= 0) {
+                    it[u]++;
+                    continue;
+                }
+
+                int v = g.to[a];
+                ll f = min(excess[u], g.cap[a]);
+                g.push(a, f);
+                excess[u] -= f;
+
+                if (excess[v] <= 0 && excess[v] + f > 0) {
+                    active.push(v);
+                }
+                excess[v] += f;
+            }
+        }
+    }
+
+    /**
+     * Lower the price of u so that at least one
+     * residual arc leaving it becomes admissible
+     */
+    void relabel(int u, ll eps)
+    {
+        ll best = -INF;
+        for (int a = g.offset[u]; a < g.offset[u + 1]; ++a) {
+            if (g.cap[a] == 0) {
+                continue;
+            }
+
+            best = max(best, price[g.to[a]] - g.cost[a] * (n + 1));
+        }
+
+        price[u] = best - eps;
+        it[u] = g.offset[u];
     }
 };
 
-int main()
+/**
+ * Grid instance for the benchmark, source feeds the
+ * left column and the right column drains into the sink
+ *
+ * @return {node count, edges}, source is n - 2 and sink n - 1
+ */
+pair<int, EdgeList> grid_instance(int rows, int cols, int max_cap, int max_cost, mt19937 & rng)
+{
+    int n = rows * cols + 2;
+    int src = n - 2;
+    int sink = n - 1;
+    EdgeList edges;
+
+    auto id = [&](int r, int c) { return r * cols + c; };
+    for (int r = 0; r < rows; ++r) {
+        edges.push_back({src, id(r, 0), 0, (int) (rng() % max_cap) + 1});
+        edges.push_back({id(r, cols - 1), sink, 0, (int) (rng() % max_cap) + 1});
+
+        for (int c = 0; c < cols; ++c) {
+            if (c + 1 < cols) {
+                edges.push_back({id(r, c), id(r, c + 1), (int) (rng() % max_cost), (int) (rng() % max_cap) + 1});
+            }
+            if (r + 1 < rows) {
+                edges.push_back({id(r, c), id(r + 1, c), (int) (rng() % max_cost), (int) (rng() % max_cap) + 1});
+                edges.push_back({id(r + 1, c), id(r, c), (int) (rng() % max_cost), (int) (rng() % max_cap) + 1});
+            }
+        }
+    }
+
+    return {n, edges};
+}
+
+/**
+ * Transportation instance for the benchmark, suppliers
+ * each ship to deg random consumers
+ *
+ * @return {node count, edges}, source is n - 2 and sink n - 1
+ */
+pair<int, EdgeList> transport_instance(int suppliers, int consumers, int deg, int max_cap, int max_cost, mt19937 & rng)
+{
+    int n = suppliers + consumers + 2;
+    int src = n - 2;
+    int sink = n - 1;
+    EdgeList edges;
+
+    for (int i = 0; i < suppliers; ++i) {
+        edges.push_back({src, i, 0, (int) (rng() % max_cap) + 1});
+
+        for (int k = 0; k < deg; ++k) {
+            int j = suppliers + rng() % consumers;
+            edges.push_back({i, j, (int) (rng() % max_cost), max_cap});
+        }
+    }
+
+    for (int j = 0; j < consumers; ++j) {
+        edges.push_back({suppliers + j, sink, 0, (int) (rng() % max_cap) + 1});
+    }
+
+    return {n, edges};
+}
+
+/**
+ * Benchmark all engines on generated instances
+ */
+int bench()
+{
+    mt19937 rng(95);
+
+    vector<pair<string, pair<int, EdgeList>>> instances;
+    instances.push_back({"grid 30x30 cap 10", grid_instance(30, 30, 10, 100, rng)});
+    instances.push_back({"grid 60x60 cap 1e6", grid_instance(60, 60, 1000000, 100, rng)});
+    instances.push_back({"transport 200x200 cap 100", transport_instance(200, 200, 10, 100, 1000, rng)});
+    instances.push_back({"transport 1000x1000 cap 1e6", transport_instance(1000, 1000, 10, 1000000, 1000, rng)});
+
+    bool ok = true;
+    for (auto & [name, instance] : instances) {
+        auto & [n, edges] = instance;
+        int src = n - 2;
+        int sink = n - 1;
+
+        cout << name << " (n = " << n << ", m = " << edges.size() << ")\n";
+
+        vector<pair<string, function<Result()>>> modes = {
+            {"ssp", [&]() { return SSP(n, edges).min_cost_max_flow(src, sink); }},
+            {"ssp capacity scaling", [&]() { return SSP(n, edges).capacity_scaling(src, sink); }},
+            {"cost scaling", [&]() { return CostScaling(n, edges).min_cost_max_flow(src, sink); }},
+        };
+
+        vector<pair<ll, ll>> answers;
+        for (auto & [mode, run] : modes) {
+            auto start = chrono::steady_clock::now();
+            Result res = run();
+            auto end = chrono::steady_clock::now();
+
+            cout << "  " << mode << ": flow " << res.flow << " cost " << res.cost << " "
+                 << chrono::duration<double, milli>(end - start).count() << " ms\n";
+            answers.push_back({res.flow, res.cost});
+        }
+
+        for (auto & a : answers) {
+            ok = ok && a == answers[0];
+        }
+    }
+
+    // Negative cycle not reachable from the source, every engine rejects it
+    {
+        EdgeList edges = {{0, 1, 1, 1}, {2, 3, -5, 1}, {3, 2, -5, 1}};
+
+        vector<pair<string, function<Result()>>> modes = {
+            {"ssp", [&]() { return SSP(4, edges).min_cost_max_flow(0, 1); }},
+            {"ssp capacity scaling", [&]() { return SSP(4, edges).capacity_scaling(0, 1); }},
+            {"cost scaling", [&]() { return CostScaling(4, edges).min_cost_max_flow(0, 1); }},
+        };
+
+        cout << "unreachable negative cycle\n";
+        for (auto & [mode, run] : modes) {
+            bool rejected = false;
+            try {
+                run();
+            } catch (const runtime_error &) {
+                rejected = true;
+            }
+
+            cout << "  " << mode << ": " << (rejected ? "rejected" : "accepted") << "\n";
+            ok = ok && rejected;
+        }
+    }
+
+    cout << (ok ? "ok" : "MISMATCH") << endl;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char ** argv)
 {
     cin.tie(nullptr);
     cin.sync_with_stdio(false);
 
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
+
     int n, m, s, t;
     cin >> n >> m >> s >> t;
 
@@ -410,4 +1208,4 @@ int main()
     cout << flush;
 
     return 0;
-}
\ No newline at end of file
+}
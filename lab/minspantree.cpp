@@ -1,6 +1,20 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <numeric>
+#include <atomic>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <array>
+#include <tuple>
+#include <limits>
+
+#include "../util/unionfind.cpp"
+#include "../util/parallel.cpp"
+#include "../util/bench.cpp"
 
 /**
  * @author Oskar Arensmeier
@@ -32,84 +46,25 @@
  * 
  *  O(n + m)
  * Edges are stored using a vector, and union-find uses two arrays of size n.
+ *
+ * Besides the plain sort, MST offers three faster ways to get there:
+ *
+ * - run_filter_kruskal(): partitions edges around pivots and filters out
+ *   heavy edges inside a component before they are ever sorted
+ * - run_radix(): Kruskal with a radix sort on the integer weights
+ * - run_boruvka(): parallel Borůvka on a CSR graph with a concurrent
+ *   union-find, see util/unionfind.cpp
+ *
+ * Costs are summed in 64 bits. bench() compares all four on random
+ * graphs with 10^7 edges.
+ *
+ * When edges arrive one at a time and the cost is needed after each,
+ * IncrementalMST keeps the forest in a link-cut tree instead of
+ * recomputing, also compared in bench().
  */
 
 using namespace std;
-
-class UnionFind {
-private:
-    int *parent;
-    int *rank;
-    int size;
-
-public:
-    UnionFind(int n)
-    {
-        size   = n;
-        parent = new int[n];
-        rank   = new int[n];
-
-        for (int i = 0; i < n; i++) {
-            parent[i] = i;
-            rank[i] = 0;
-        }
-    }
-
-    ~UnionFind()
-    {
-        delete[] parent;
-        delete[] rank;
-    }
-
-    /**
-     * Find set representative for element x
-     * @param x element
-     * @return set representative
-     */
-    int find(int x)
-    {
-        if (parent[x] != x) {
-            return parent[x] = find(parent[x]);
-        }
-
-        return parent[x];
-    }
-
-    /**
-     * Join (union) two sets
-     * @param x first set
-     * @param y second set
-     */
-    void join(int x, int y)
-    {
-        int rx = find(x);
-        int ry = find(y);
-
-        if (rx == ry) {
-            return;
-        }
-
-        if (rank[rx] < rank[ry]) {
-            swap(rx, ry);
-        }
-
-        parent[ry] = rx;
-
-        if (rank[rx] == rank[ry]) {
-            rank[rx]++;
-        }
-    }
-
-    /**
-     * Check if two sets are the same
-     * @param x first set
-     * @param y second set
-     */
-    bool same(int x, int y)
-    {
-        return find(x) == find(y);
-    }
-};
+using ll = long long;
 
 class Edge
 {
@@ -119,6 +74,8 @@ public:
      */
     int u, v, w;
 
+    Edge() = default;
+
     Edge(int u, int v, int w) : u(u), v(v), w(w) {}
 
     /**
@@ -139,7 +96,7 @@ public:
     /**
      * Set for Kruskal's algorithm
      */
-    UnionFind uf;
+    DSU::UnionFind uf;
 
     /**
      * Graph
@@ -159,42 +116,171 @@ public:
     /**
      * Cost
      */
-    int cost = 0;
+    ll cost = 0;
 
     /**
      * Constructor
      *
-     * @param edges Edges
+     * @param edges Edges, moved from if passed as an rvalue
      * @param n Number of nodes
      */
-    MST(vector<Edge> edges, int n) : edges(edges), uf(UnionFind(n)), n(n) {
-        mst.reserve(n-1);
+    MST(vector<Edge> edges, int n) : uf(n), edges(std::move(edges)), n(n) {
+        mst.reserve(max(n - 1, 0));
     }
 
+    /**
+     * Kruskal's algorithm on fully sorted edges
+     */
     void run()
     {
+        reset();
+
         // Sort edges
         // Time: O(m log m)
         sort(edges.begin(), edges.end());
 
-        // Kruskal's algorithm
-        for (const auto &edge : edges) {
+        kruskal(edges.data(), edges.data() + edges.size());
+    }
 
-            // We're done if we have n-1 edges
-            if (mst.size() == n - 1) {
-                break;
-            }
+    /**
+     * Filter-Kruskal: like quicksort, partition the edges around a random
+     * pivot weight and recurse on the light half first. Before recursing
+     * on the heavy half, drop its edges whose endpoints are already
+     * connected. On graphs with m >> n most heavy edges are filtered out
+     * this way and never sorted.
+     *
+     * reference: Osipov, Sanders, Singler, "The Filter-Kruskal Minimum
+     * Spanning Tree Algorithm" (ALENEX 2009)
+     *
+     * Time: O(m + n log n log(m / n)) expected on random graphs
+     */
+    void run_filter_kruskal()
+    {
+        reset();
+
+        mt19937 rng(edges.size());
+        filter_kruskal(edges.data(), edges.data() + edges.size(), rng);
+    }
+
+    /**
+     * Kruskal's algorithm with the edges sorted by an LSD radix sort on
+     * the integer weights, three passes of 11 bits
+     *
+     * Time: O(m)
+     */
+    void run_radix()
+    {
+        reset();
+
+        radix_sort(edges);
+        kruskal(edges.data(), edges.data() + edges.size());
+    }
 
-            int u = edge.u;
-            int v = edge.v;
-            int w = edge.w;
+    /**
+     * Parallel Borůvka: in each round every component picks its cheapest
+     * outgoing edge and all picked edges are added at once, which at
+     * least halves the number of components.
+     *
+     * The edges are radix sorted first and their positions used as keys,
+     * which also breaks ties, so the picked edges never form a cycle. The
+     * graph is then stored in CSR form, filled in key order, so the arcs
+     * of each node come out sorted: the cheapest outgoing arc of a node is
+     * its first arc that is not internal to its component, and internal
+     * arcs stay internal, so they are skipped from the front for good.
+     *
+     * Each round records the root of every node, then threads take blocks
+     * of nodes, advance past internal arcs and lower the candidate of the
+     * root with an atomic min. The picked edges are joined in parallel in
+     * a DSU::ConcurrentUnionFind; a join that finds both ends already
+     * connected is an edge picked from both sides.
+     *
+     * Time: O(m) to sort, O((m + n log n) / threads) for the rounds
+     *
+     * @param threads Number of threads
+     */
+    void run_boruvka(int threads = thread::hardware_concurrency())
+    {
+        reset();
+
+        if ((ll) edges.size() >= (ll) UINT32_MAX) {
+            throw length_error("run_boruvka supports fewer than 2^32 - 1 edges");
+        }
+
+        const ll BLOCK = 1 << 12;
+        const uint32_t NONE = UINT32_MAX;
+        ll blocks = (n + BLOCK - 1) / BLOCK;
+
+        radix_sort(edges);
+
+        // CSR, each edge appears once at each endpoint
+        vector<uint32_t> start(n + 1, 0);
+        for (const Edge & e : edges) {
+            ++start[e.u + 1];
+            ++start[e.v + 1];
+        }
+        partial_sum(start.begin(), start.end(), start.begin());
+
+        vector<Arc> arcs(start[n]);
+        vector<uint32_t> end(start.begin(), start.end() - 1);
+        for (uint32_t i = 0; i < edges.size(); ++i) {
+            const Edge & e = edges[i];
+            arcs[end[e.u]++] = {(uint32_t) e.v, i};
+            arcs[end[e.v]++] = {(uint32_t) e.u, i};
+        }
 
-            if (! uf.same(u, v)) {
-                mst.push_back(edge);
-                uf.join(u, v);
-                cost += w;
+        DSU::ConcurrentUnionFind dsu(n);
+        vector<uint32_t> root(n);
+        vector<atomic<uint32_t>> best(n);
+        vector<uint32_t> picked(max(n - 1, 0));
+        atomic<ll> count = 0;
+
+        while (count < n - 1) {
+            Parallel::parallel_for(blocks, threads, [&](ll b) {
+                for (ll u = b * BLOCK; u < min<ll>(n, (b + 1) * BLOCK); ++u) {
+                    root[u] = dsu.find(u);
+                    best[u].store(NONE, memory_order_relaxed);
+                }
+            });
+
+            Parallel::parallel_for(blocks, threads, [&](ll b) {
+                for (ll u = b * BLOCK; u < min<ll>(n, (b + 1) * BLOCK); ++u) {
+                    uint32_t r = root[u];
+                    uint32_t & k = start[u];
+
+                    while (k < end[u] && root[arcs[k].v] == r) {
+                        ++k;
+                    }
+
+                    if (k == end[u]) {
+                        continue;
+                    }
+
+                    uint32_t cheapest = arcs[k].edge;
+                    uint32_t cur = best[r].load(memory_order_relaxed);
+                    while (cheapest < cur && !best[r].compare_exchange_weak(cur, cheapest, memory_order_relaxed));
+                }
+            });
+
+            ll before = count;
+            Parallel::parallel_for(blocks, threads, [&](ll b) {
+                for (ll u = b * BLOCK; u < min<ll>(n, (b + 1) * BLOCK); ++u) {
+                    uint32_t i = best[u].load(memory_order_relaxed);
+                    if (i != NONE && dsu.join(edges[i].u, edges[i].v)) {
+                        picked[count++] = i;
+                    }
+                }
+            });
+
+            // No outgoing edges left, the graph is disconnected
+            if (count == before) {
+                break;
             }
         }
+
+        for (ll k = 0; k < count; ++k) {
+            mst.push_back(edges[picked[k]]);
+            cost += edges[picked[k]].w;
+        }
     }
 
     /**
@@ -202,7 +288,7 @@ public:
      * 
      * @return Cost
      */
-    int get_cost()
+    ll get_cost()
     {
         return cost;
     }
@@ -216,13 +302,536 @@ public:
     {
         return mst;
     }
+
+private:
+
+    /**
+     * Ranges of at most this many edges are sorted directly by filter-Kruskal
+     */
+    static const int FILTER_THRESHOLD = 1 << 12;
+
+    /**
+     * Arc of the CSR graph: other endpoint and index of the edge
+     */
+    struct Arc {
+        uint32_t v;
+        uint32_t edge;
+    };
+
+    void reset()
+    {
+        uf = DSU::UnionFind(n);
+        mst.clear();
+        cost = 0;
+    }
+
+    bool done()
+    {
+        return (int) mst.size() >= n - 1;
+    }
+
+    /**
+     * Kruskal's algorithm over sorted edges [first, last)
+     */
+    void kruskal(const Edge * first, const Edge * last)
+    {
+        for (; first != last && !done(); ++first) {
+            if (! uf.same(first->u, first->v)) {
+                mst.push_back(*first);
+                uf.join(first->u, first->v);
+                cost += first->w;
+            }
+        }
+    }
+
+    void filter_kruskal(Edge * first, Edge * last, mt19937 & rng)
+    {
+        if (done()) {
+            return;
+        }
+
+        if (last - first <= FILTER_THRESHOLD) {
+            sort(first, last);
+            kruskal(first, last);
+            return;
+        }
+
+        int pivot = first[rng() % (last - first)].w;
+        Edge * mid = partition(first, last, [&](const Edge & e) { return e.w < pivot; });
+
+        if (mid == first) {
+            // Pivot is the lightest weight, take all edges of that weight
+            mid = partition(first, last, [&](const Edge & e) { return e.w == pivot; });
+            kruskal(first, mid);
+        } else {
+            filter_kruskal(first, mid, rng);
+        }
+
+        if (done()) {
+            return;
+        }
+
+        Edge * keep = partition(mid, last, [&](const Edge & e) { return ! uf.same(e.u, e.v); });
+        filter_kruskal(mid, keep, rng);
+    }
+
+    static void radix_sort(vector<Edge> & a)
+    {
+        const int BITS = 11;
+        const int BUCKETS = 1 << BITS;
+
+        vector<Edge> tmp(a.size());
+        for (int shift = 0; shift < 32; shift += BITS) {
+            vector<size_t> pos(BUCKETS + 1, 0);
+            for (const Edge & e : a) {
+                ++pos[(((uint32_t) e.w ^ 0x80000000u) >> shift & (BUCKETS - 1)) + 1];
+            }
+
+            // All edges share this digit
+            if (*max_element(pos.begin(), pos.end()) == a.size()) {
+                continue;
+            }
+
+            partial_sum(pos.begin(), pos.end(), pos.begin());
+            for (const Edge & e : a) {
+                tmp[pos[((uint32_t) e.w ^ 0x80000000u) >> shift & (BUCKETS - 1)]++] = e;
+            }
+            a.swap(tmp);
+        }
+    }
 };
 
-int main()
+/**
+ * Minimum spanning forest under edge insertions.
+ *
+ * reference: Sleator, Tarjan, "A Data Structure for Dynamic Trees" (1983)
+ *
+ * Algorithm:
+ *
+ * The current forest is kept in a link-cut tree. Every tree edge is a node
+ * of its own between its two endpoints, so path aggregates over nodes are
+ * aggregates over edges. Each splay tree node stores the heaviest edge
+ * node in its subtree.
+ *
+ * Adding an edge (u, v, w):
+ * - If u and v are in different trees, link them through the new edge.
+ * - Otherwise the edge closes a cycle with the tree path u..v. By the cycle
+ *   property the heaviest edge of that cycle is not in the MST, so if the
+ *   heaviest path edge is heavier than w, cut it and link the new edge,
+ *   else drop the new edge.
+ *
+ * Edge nodes of cut edges are reused, so at most 2n - 1 nodes exist.
+ *
+ * Time complexity: O(log n) amortized per insertion, O(1) for the cost
+ * Space complexity: O(n)
+ */
+class IncrementalMST
+{
+public:
+    /**
+     * @param n Number of nodes
+     */
+    IncrementalMST(int n) : n(n), t(n)
+    {
+        for (int i = 0; i < n; ++i) {
+            t[i].best = i;
+        }
+    }
+
+    /**
+     * Add an edge and update the forest
+     *
+     * @param u First node
+     * @param v Second node
+     * @param w Weight
+     * @return True if the edge is now part of the forest
+     */
+    bool add_edge(int u, int v, int w)
+    {
+        if (u == v) {
+            return false;
+        }
+
+        // With u as root, find_root(v) leaves the path u..v as the splay
+        // tree of u, whose best is the heaviest edge on the cycle the new
+        // edge would close
+        make_root(u);
+        if (find_root(v) != u) {
+            attach(u, v, w);
+            return true;
+        }
+
+        int e = t[u].best;
+        if (t[e].val <= w) {
+            return false;
+        }
+
+        cut(ends[e - n].u, e);
+        cut(e, ends[e - n].v);
+        cost -= t[e].val;
+        --tree_edges;
+        free_nodes.push_back(e);
+
+        attach(u, v, w);
+        return true;
+    }
+
+    /**
+     * Check if two nodes are connected in the forest
+     */
+    bool connected(int u, int v)
+    {
+        return find_root(u) == find_root(v);
+    }
+
+    /**
+     * Total weight of the current minimum spanning forest
+     */
+    ll get_cost() const
+    {
+        return cost;
+    }
+
+    /**
+     * Number of edges in the current forest, n - 1 once connected
+     */
+    int size() const
+    {
+        return tree_edges;
+    }
+
+    /**
+     * Current minimum spanning forest
+     *
+     * Time: O(n)
+     */
+    vector<Edge> get_mst() const
+    {
+        vector<char> is_free(ends.size(), false);
+        for (int e : free_nodes) {
+            is_free[e - n] = true;
+        }
+
+        vector<Edge> res;
+        res.reserve(tree_edges);
+        for (size_t i = 0; i < ends.size(); ++i) {
+            if (! is_free[i]) {
+                res.push_back(ends[i]);
+            }
+        }
+
+        return res;
+    }
+
+private:
+
+    /**
+     * Value of graph nodes, below every edge weight
+     */
+    static constexpr ll NO_EDGE = numeric_limits<ll>::min();
+
+    /**
+     * Splay tree node, all fields in one 32 byte record so that a
+     * rotation touches as few cache lines as possible
+     */
+    struct Node {
+        /** Children, -1 if none */
+        int ch[2] = {-1, -1};
+
+        /** Splay parent, or path parent for splay roots, -1 if none */
+        int parent = -1;
+
+        /** Node with the largest val in the splay subtree */
+        int best = 0;
+
+        /** Edge weight, NO_EDGE for graph nodes */
+        ll val = NO_EDGE;
+
+        /** Pending reversal of the subtree */
+        bool rev = false;
+    };
+
+    /**
+     * Number of graph nodes, nodes >= n are edges
+     */
+    int n;
+
+    /**
+     * Graph nodes followed by edge nodes
+     */
+    vector<Node> t;
+
+    /**
+     * Endpoints and weight of edge node n + i
+     */
+    vector<Edge> ends;
+
+    /**
+     * Edge nodes of cut edges, for reuse
+     */
+    vector<int> free_nodes;
+
+    /**
+     * Scratch stack for splay()
+     */
+    vector<int> path;
+
+    ll cost = 0;
+    int tree_edges = 0;
+
+    /**
+     * Link u and v through a new edge node
+     */
+    void attach(int u, int v, int w)
+    {
+        int e;
+        if (free_nodes.empty()) {
+            e = t.size();
+            t.emplace_back();
+            ends.push_back(Edge(u, v, w));
+        } else {
+            e = free_nodes.back();
+            free_nodes.pop_back();
+            t[e] = Node();
+            ends[e - n] = Edge(u, v, w);
+        }
+
+        t[e].best = e;
+        t[e].val = w;
+
+        link(u, e);
+        link(e, v);
+        cost += w;
+        ++tree_edges;
+    }
+
+    bool is_root(int x)
+    {
+        int p = t[x].parent;
+        return p == -1 || (t[p].ch[0] != x && t[p].ch[1] != x);
+    }
+
+    void push(int x)
+    {
+        Node & a = t[x];
+        if (a.rev) {
+            swap(a.ch[0], a.ch[1]);
+            for (int c : a.ch) {
+                if (c != -1) {
+                    t[c].rev = ! t[c].rev;
+                }
+            }
+            a.rev = false;
+        }
+    }
+
+    void pull(int x)
+    {
+        Node & a = t[x];
+        a.best = x;
+        for (int c : a.ch) {
+            if (c != -1 && t[t[c].best].val > t[a.best].val) {
+                a.best = t[c].best;
+            }
+        }
+    }
+
+    void rotate(int x)
+    {
+        int p = t[x].parent;
+        int g = t[p].parent;
+        int dir = t[p].ch[1] == x;
+
+        if (! is_root(p)) {
+            t[g].ch[t[g].ch[1] == p] = x;
+        }
+        t[x].parent = g;
+
+        int c = t[x].ch[! dir];
+        t[p].ch[dir] = c;
+        if (c != -1) {
+            t[c].parent = p;
+        }
+
+        t[x].ch[! dir] = p;
+        t[p].parent = x;
+
+        pull(p);
+        pull(x);
+    }
+
+    void splay(int x)
+    {
+        // Push pending reversals from the splay root down to x
+        path.clear();
+        for (int y = x;; y = t[y].parent) {
+            path.push_back(y);
+            if (is_root(y)) {
+                break;
+            }
+        }
+        for (int i = path.size() - 1; i >= 0; --i) {
+            push(path[i]);
+        }
+
+        while (! is_root(x)) {
+            int p = t[x].parent;
+            if (! is_root(p)) {
+                int g = t[p].parent;
+                rotate((t[g].ch[1] == p) == (t[p].ch[1] == x) ? p : x);
+            }
+            rotate(x);
+        }
+    }
+
+    /**
+     * Make the root-to-x path preferred, x ends up as splay root
+     */
+    void access(int x)
+    {
+        int last = -1;
+        for (int y = x; y != -1; y = t[y].parent) {
+            splay(y);
+            t[y].ch[1] = last;
+            pull(y);
+            last = y;
+        }
+        splay(x);
+    }
+
+    void make_root(int x)
+    {
+        access(x);
+        t[x].rev = ! t[x].rev;
+    }
+
+    int find_root(int x)
+    {
+        access(x);
+        while (true) {
+            push(x);
+            if (t[x].ch[0] == -1) {
+                break;
+            }
+            x = t[x].ch[0];
+        }
+        splay(x);
+        return x;
+    }
+
+    void link(int x, int y)
+    {
+        make_root(x);
+        t[x].parent = y;
+    }
+
+    void cut(int x, int y)
+    {
+        make_root(x);
+        access(y);
+
+        // x is now the only node left of y
+        t[y].ch[0] = -1;
+        t[x].parent = -1;
+        pull(y);
+    }
+};
+
+/**
+ * Time the MST variants on random graphs with 10^7 edges, and
+ * IncrementalMST against recomputation, checking that they agree on
+ * the cost
+ */
+int bench()
+{
+    mt19937 rng(1);
+    bool ok = true;
+
+    int threads = thread::hardware_concurrency();
+
+    for (auto [n, max_w] : {pair<int, int>{1000000, 1000000000}, {1000000, 256}, {5000000, 1000000000}}) {
+        const int m = 10000000;
+
+        vector<Edge> edges;
+        edges.reserve(m);
+        for (int i = 0; i < m; ++i) {
+            edges.emplace_back(rng() % n, rng() % n, rng() % max_w);
+        }
+
+        cout << "n = " << n << ", m = " << m << ", weights < " << max_w << "\n";
+
+        ll cost = -1;
+        auto check = [&](const char * name, auto run) {
+            MST mst(edges, n);
+            double t = Bench::time([&] { run(mst); });
+            cout << "  " << name << ": " << t << " ms\n";
+
+            if (cost == -1) {
+                cost = mst.get_cost();
+                cout << "  cost: " << cost << ", tree edges: " << mst.get_mst().size() << "\n";
+            }
+            ok = ok && mst.get_cost() == cost;
+        };
+
+        check("sort + kruskal", [](MST & mst) { mst.run(); });
+        check("filter-kruskal", [](MST & mst) { mst.run_filter_kruskal(); });
+        check("radix + kruskal", [](MST & mst) { mst.run_radix(); });
+        check("boruvka, 1 thread", [](MST & mst) { mst.run_boruvka(1); });
+        if (threads > 1) {
+            check("boruvka, all threads", [&](MST & mst) { mst.run_boruvka(threads); });
+        }
+    }
+
+    // Cost after every insertion, incrementally and by recomputing
+    for (auto [n, m, recompute] : {tuple<int, int, bool>{1000, 20000, true}, {200000, 2000000, false}}) {
+        vector<Edge> edges;
+        edges.reserve(m);
+        for (int i = 0; i < m; ++i) {
+            edges.emplace_back(rng() % n, rng() % n, rng() % 1000000000);
+        }
+
+        cout << "incremental, n = " << n << ", m = " << m << "\n";
+
+        ll incremental_sum = 0;
+        double t = Bench::time([&] {
+            IncrementalMST inc(n);
+            for (const Edge & e : edges) {
+                inc.add_edge(e.u, e.v, e.w);
+                incremental_sum += inc.get_cost();
+            }
+        });
+        cout << "  link-cut tree: " << t << " ms\n";
+
+        if (recompute) {
+            ll recompute_sum = 0;
+            t = Bench::time([&] {
+                for (int i = 1; i <= m; ++i) {
+                    MST mst(vector<Edge>(edges.begin(), edges.begin() + i), n);
+                    mst.run_radix();
+                    recompute_sum += mst.get_cost();
+                }
+            });
+            cout << "  recompute each time: " << t << " ms\n";
+            ok = ok && recompute_sum == incremental_sum;
+        } else {
+            MST mst(edges, n);
+            t = Bench::time([&] { mst.run_filter_kruskal(); });
+            cout << "  recompute once: " << t << " ms\n";
+        }
+    }
+
+    return Bench::report(ok);
+}
+
+int main(int argc, char ** argv)
 {
     cin.sync_with_stdio(false);
     cin.tie(nullptr);
 
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
+
     int n, m;
 
     while (1) {
@@ -245,11 +854,11 @@ int main()
         }
 
         // Run Kruskal's
-        MST mst(edges, n);
-        mst.run();
+        MST mst(std::move(edges), n);
+        mst.run_filter_kruskal();
 
         // Get solution
-        int cost = mst.get_cost();
+        ll cost = mst.get_cost();
         vector<Edge> mst_edges = mst.get_mst();
 
         // MST must have exactly n-1 edges
@@ -2,6 +2,16 @@
 #include <vector>
 #include <complex>
 #include <cmath>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <stdexcept>
+#include "../util/parallel.cpp"
 
 /**
  * @author Oskar Arensmeier
@@ -26,6 +36,20 @@
  * faster then the naive O(n^2) approach since the Fast Fourier Transform
  * allows us to compute the DFT in O(n log n) time.
  *
+ * The transform is iterative: a bit reversal permutation followed by
+ * log n butterfly passes, reading the twiddles from a table that is
+ * computed once (in long double) and grown on demand, instead of
+ * accumulating them with w *= wn.
+ *
+ * multiply() packs A into the real and B into the imaginary part, so one
+ * forward and one inverse transform suffice ("two for one"). Doubles are
+ * exact as long as the result coefficients stay well below 2^50 / n.
+ *
+ * multiply_exact() runs the number theoretic transform (the same
+ * algorithm over Z/p) for three primes and combines the residues with the
+ * Chinese remainder theorem (Garner), exact for any result that fits in
+ * 64 bits, up to 2^25 coefficients.
+ *
  * Data structures:
  * - Vectors
  * - Complex numbers
@@ -37,16 +61,63 @@
 
 using namespace std;
 
+using ll = long long;
+
 using cd = complex<double>;
 
 const double PI = acos(-1);
 
+/**
+ * Twiddle table, roots[k + j] = e^(i * pi * j / k) for
+ * every power of two k < size and 0 <= j < k
+ *
+ * @note Growing is not thread safe, call with the largest
+ * size first when transforming from several threads
+ */
+const vector<cd> & fft_roots(int n)
+{
+    static vector<cd> roots(2, 1);
+    const long double pi = acosl(-1);
+
+    for (int k = roots.size() / 2; 2 * k < n; k *= 2) {
+        roots.resize(4 * k);
+
+        // Even entries repeat the previous level, odd ones
+        // are computed directly in long double and rounded once
+        for (int i = 2 * k; i < 4 * k; ++i) {
+            roots[i] = i & 1 ? cd(polar(1.0L, pi * (i - 2 * k) / (2 * k))) : roots[i / 2];
+        }
+    }
+
+    return roots;
+}
+
+/**
+ * Reorder a by bit reversed index
+ */
+template <class T>
+void bit_reverse(vector<T> & a)
+{
+    int n = a.size();
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+
+        if (i < j) {
+            swap(a[i], a[j]);
+        }
+    }
+}
+
 /**
  * Fast Fourier Transform
  * as seen at https://cp-algorithms.com/algebra/fft.html.
  * The result is computed in-place on the input vector.
  *
- * @param a vector of complex numbers
+ * @param a vector of complex numbers, size a power of two
  * @param invert if true, performs inverse DFT
  */
 void fft(vector<cd> & a, bool invert)
@@ -56,69 +127,703 @@ void fft(vector<cd> & a, bool invert)
         return;
     }
 
-    vector<cd> a0(n / 2), a1(n / 2);
-    for (int i = 0; 2 * i < n; i++) {
-        a0[i] = a[2*i];
-        a1[i] = a[2*i+1];
+    // Inverse DFT = DFT with reversed output, scaled by 1 / n
+    if (invert) {
+        reverse(a.begin() + 1, a.end());
     }
 
-    fft(a0, invert);
-    fft(a1, invert);
+    const vector<cd> & roots = fft_roots(n);
+    bit_reverse(a);
 
-    double ang = 2 * PI / n * (invert ? -1 : 1);
-    cd w(1), wn(cos(ang), sin(ang));
+    for (int k = 1; k < n; k *= 2) {
+        for (int i = 0; i < n; i += 2 * k) {
+            for (int j = 0; j < k; ++j) {
+                cd z = roots[k + j] * a[i + j + k];
+                a[i + j + k] = a[i + j] - z;
+                a[i + j] += z;
+            }
+        }
+    }
 
-    for (int i = 0; 2 * i < n; i++) {
+    if (invert) {
+        for (cd & x : a) {
+            x /= n;
+        }
+    }
+}
 
-        a[i] = a0[i] + w * a1[i];
-        a[i + n/2] = a0[i] - w * a1[i];
+/**
+ * Multiply two integer polynomials with doubles
+ *
+ * @return Coefficients of a * b, size a.size() + b.size() - 1
+ * @note Exact only while the coefficients of the
+ * result stay well below 2^50 / n, see multiply_exact()
+ */
+template <class T>
+vector<ll> multiply(vector<T> const& a, vector<T> const& b)
+{
+    if (a.empty() || b.empty()) {
+        return {};
+    }
+
+    int size = a.size() + b.size() - 1;
+    int n = 1;
+    while (n < size) {
+        n <<= 1;
+    }
+
+    // A in the real part, B in the imaginary part
+    vector<cd> f(n);
+    for (size_t i = 0; i < a.size(); ++i) {
+        f[i].real(a[i]);
+    }
+    for (size_t i = 0; i < b.size(); ++i) {
+        f[i].imag(b[i]);
+    }
+
+    fft(f, false);
+
+    // With F = DFT(A + iB) the product is
+    // DFT(A * B)[k] = (F[k]^2 - conj(F[-k])^2) / 4i
+    for (int i = 0; i <= n / 2; ++i) {
+        int j = (n - i) & (n - 1);
+        cd x = f[i] * f[i];
+        cd y = f[j] * f[j];
+
+        f[i] = (x - conj(y)) * cd(0, -0.25);
+        f[j] = (y - conj(x)) * cd(0, -0.25);
+    }
+
+    fft(f, true);
+
+    vector<ll> result(size);
+    for (int i = 0; i < size; i++) {
+        result[i] = llround(f[i].real());
+    }
+
+    return result;
+}
+
+/**
+ * Number theoretic transform modulo a prime MOD = c * 2^k + 1
+ * with primitive root G, supports sizes up to 2^k
+ */
+template <uint32_t MOD, uint32_t G>
+class NTT
+{
+public:
+    /**
+     * a^e mod MOD
+     */
+    static uint32_t power(uint64_t a, uint64_t e)
+    {
+        uint64_t r = 1;
+        for (a %= MOD; e > 0; e >>= 1) {
+            if (e & 1) {
+                r = r * a % MOD;
+            }
+            a = a * a % MOD;
+        }
+        return r;
+    }
+
+    /**
+     * Twiddle table, same layout as fft_roots()
+     *
+     * @note Growing is not thread safe
+     */
+    static const vector<uint32_t> & roots(int n)
+    {
+        static vector<uint32_t> table(2, 1);
+
+        for (int k = table.size() / 2; 2 * k < n; k *= 2) {
+            table.resize(4 * k);
+
+            // Primitive 4k-th root of unity
+            uint64_t x = power(G, (MOD - 1) / (4 * k));
+            for (int i = 2 * k; i < 4 * k; ++i) {
+                table[i] = i & 1 ? table[i / 2] * x % MOD : table[i / 2];
+            }
+        }
+
+        return table;
+    }
+
+    /**
+     * In-place transform, size a power of two
+     */
+    static void transform(vector<uint32_t> & a, bool invert)
+    {
+        int n = a.size();
+        if (n == 1) {
+            return;
+        }
 
         if (invert) {
-            a[i] /= 2;
-            a[i + n/2] /= 2;
+            reverse(a.begin() + 1, a.end());
+        }
+
+        const vector<uint32_t> & rt = roots(n);
+        bit_reverse(a);
+
+        for (int k = 1; k < n; k *= 2) {
+            for (int i = 0; i < n; i += 2 * k) {
+                for (int j = 0; j < k; ++j) {
+                    uint32_t z = (uint64_t) rt[k + j] * a[i + j + k] % MOD;
+                    uint32_t x = a[i + j];
+                    a[i + j + k] = x >= z ? x - z : x + MOD - z;
+                    a[i + j] = x + z >= MOD ? x + z - MOD : x + z;
+                }
+            }
         }
 
-        w *= wn;
+        if (invert) {
+            uint64_t inv = power(n, MOD - 2);
+            for (uint32_t & x : a) {
+                x = x * inv % MOD;
+            }
+        }
     }
-}
 
-vector<int> multiply(vector<int> const& a, vector<int> const& b)
+    /**
+     * a * b mod MOD, n a power of two >= a.size() + b.size() - 1
+     */
+    static vector<uint32_t> multiply(vector<ll> const& a, vector<ll> const& b, int n)
+    {
+        vector<uint32_t> fa(n, 0), fb(n, 0);
+        for (size_t i = 0; i < a.size(); ++i) {
+            fa[i] = (a[i] % (ll) MOD + MOD) % MOD;
+        }
+        for (size_t i = 0; i < b.size(); ++i) {
+            fb[i] = (b[i] % (ll) MOD + MOD) % MOD;
+        }
+
+        transform(fa, false);
+        transform(fb, false);
+
+        for (int i = 0; i < n; ++i) {
+            fa[i] = (uint64_t) fa[i] * fb[i] % MOD;
+        }
+
+        transform(fa, true);
+        return fa;
+    }
+};
+
+/**
+ * Primes for multiply_exact, all 2^25 | p - 1
+ */
+using NTT1 = NTT<167772161, 3>;
+using NTT2 = NTT<469762049, 3>;
+using NTT3 = NTT<2013265921, 31>;
+
+/**
+ * Multiply two integer polynomials exactly
+ *
+ * @return Coefficients of a * b, size a.size() + b.size() - 1
+ * @note Exact whenever every result coefficient fits in 64 bits,
+ * at most 2^25 coefficients
+ */
+vector<ll> multiply_exact(vector<ll> const& a, vector<ll> const& b)
 {
-    vector<cd> fa(a.begin(), a.end()), fb(b.begin(), b.end());
+    if (a.empty() || b.empty()) {
+        return {};
+    }
 
+    int size = a.size() + b.size() - 1;
     int n = 1;
-    while (n < a.size() + b.size()) {
+    while (n < size) {
         n <<= 1;
     }
 
-    fa.resize(n);
-    fb.resize(n);
+    if (n > (1 << 25)) {
+        throw length_error("multiply_exact supports at most 2^25 coefficients");
+    }
 
-    // DFT(A), DFT(B) : O(n log n)
-    fft(fa, false);
-    fft(fb, false);
+    const ll M1 = 167772161, M2 = 469762049, M3 = 2013265921;
 
-    // DFT(A) * DFT(B) (pairwise) : O(n)
-    for (int i = 0; i < n; i++) {
-        fa[i] *= fb[i];
+    vector<uint32_t> r1 = NTT1::multiply(a, b, n);
+    vector<uint32_t> r2 = NTT2::multiply(a, b, n);
+    vector<uint32_t> r3 = NTT3::multiply(a, b, n);
+
+    // Garner, x = x1 + M1 * t2 + M1 * M2 * t3
+    const ll inv1 = NTT2::power(M1, M2 - 2);
+    const ll inv12 = NTT3::power(M1 * M2 % M3, M3 - 2);
+    const __int128 M = (__int128) M1 * M2 * M3;
+
+    vector<ll> result(size);
+    for (int i = 0; i < size; ++i) {
+        ll t2 = (r2[i] - (ll) r1[i] % M2 + M2) % M2 * inv1 % M2;
+        ll x12 = r1[i] + M1 * t2;
+
+        ll t3 = ((r3[i] - x12 % M3) % M3 + M3) % M3 * inv12 % M3;
+        __int128 x = x12 + (__int128) M1 * M2 * t3;
+
+        // Residue to signed
+        if (x > M / 2) {
+            x -= M;
+        }
+        result[i] = (ll) x;
     }
 
-    // InverseDFT(DFT(A) * DFT(B)) : O(n log n)
-    fft(fa, true);
+    return result;
+}
 
-    vector<int> result(n);
-    for (int i = 0; i < n; i++) {
-        result[i] = round(fa[i].real());
+/**
+ * Batched polynomial multiplication
+ *
+ * Many products at once, spread over threads. Scratch buffers live in
+ * the object (one per thread) and are reused across calls, and the twiddle
+ * table is grown once up front for the largest size in the batch.
+ *
+ * - multiply(a, b): products a[i] * b[i], one forward and one inverse
+ *   transform each (two for one as in multiply()).
+ * - multiply(shared, others): products shared * others[i]. The shared
+ *   operand is transformed once per transform size, and the others go
+ *   in pairs: DFT(x + iy) * DFT(shared) transforms back to
+ *   (x * shared) + i (y * shared), two products per forward/inverse pair.
+ *
+ * Same precision as multiply().
+ */
+class BatchMultiplier
+{
+public:
+    /**
+     * Number of threads
+     */
+    int threads;
+
+    /**
+     * Constructor
+     *
+     * @param threads Number of threads
+     */
+    BatchMultiplier(int threads = thread::hardware_concurrency()) :
+        threads(max(1, threads)), scratch(this->threads) {}
+
+    /**
+     * Pairwise products a[i] * b[i]
+     */
+    vector<vector<ll>> multiply(vector<vector<ll>> const& a, vector<vector<ll>> const& b)
+    {
+        if (a.size() != b.size()) {
+            throw invalid_argument("a and b must have the same number of polynomials");
+        }
+
+        vector<vector<ll>> result(a.size());
+
+        int largest = 1;
+        for (size_t i = 0; i < a.size(); ++i) {
+            largest = max(largest, transform_size(a[i].size() + b[i].size() - 1));
+        }
+        fft_roots(largest);
+
+        parallel_for(a.size(), [&](int i, vector<cd> & f) {
+            if (a[i].empty() || b[i].empty()) {
+                return;
+            }
+
+            int size = a[i].size() + b[i].size() - 1;
+            int n = transform_size(size);
+
+            f.assign(n, 0);
+            for (size_t j = 0; j < a[i].size(); ++j) {
+                f[j].real(a[i][j]);
+            }
+            for (size_t j = 0; j < b[i].size(); ++j) {
+                f[j].imag(b[i][j]);
+            }
+
+            fft(f, false);
+
+            for (int j = 0; j <= n / 2; ++j) {
+                int k = (n - j) & (n - 1);
+                cd x = f[j] * f[j];
+                cd y = f[k] * f[k];
+
+                f[j] = (x - conj(y)) * cd(0, -0.25);
+                f[k] = (y - conj(x)) * cd(0, -0.25);
+            }
+
+            fft(f, true);
+
+            result[i].resize(size);
+            for (int j = 0; j < size; ++j) {
+                result[i][j] = llround(f[j].real());
+            }
+        });
+
+        return result;
+    }
+
+    /**
+     * Products shared * others[i]
+     */
+    vector<vector<ll>> multiply(vector<ll> const& shared, vector<vector<ll>> const& others)
+    {
+        vector<vector<ll>> result(others.size());
+        if (shared.empty()) {
+            return result;
+        }
+
+        // Pair up others of the same transform size
+        map<int, vector<int>> by_size;
+        for (size_t i = 0; i < others.size(); ++i) {
+            if (!others[i].empty()) {
+                by_size[transform_size(shared.size() + others[i].size() - 1)].push_back(i);
+            }
+        }
+
+        if (by_size.empty()) {
+            return result;
+        }
+        fft_roots(by_size.rbegin()->first);
+
+        for (auto & [n, indices] : by_size) {
+            // DFT(shared), once per size
+            vector<cd> fs(n, 0);
+            for (size_t j = 0; j < shared.size(); ++j) {
+                fs[j] = shared[j];
+            }
+            fft(fs, false);
+
+            int pairs = (indices.size() + 1) / 2;
+            parallel_for(pairs, [&](int p, vector<cd> & f) {
+                int x = indices[2 * p];
+                int y = 2 * p + 1 < (int) indices.size() ? indices[2 * p + 1] : -1;
+
+                f.assign(n, 0);
+                for (size_t j = 0; j < others[x].size(); ++j) {
+                    f[j].real(others[x][j]);
+                }
+                if (y != -1) {
+                    for (size_t j = 0; j < others[y].size(); ++j) {
+                        f[j].imag(others[y][j]);
+                    }
+                }
+
+                fft(f, false);
+                for (int j = 0; j < n; ++j) {
+                    f[j] *= fs[j];
+                }
+                fft(f, true);
+
+                result[x].resize(shared.size() + others[x].size() - 1);
+                for (size_t j = 0; j < result[x].size(); ++j) {
+                    result[x][j] = llround(f[j].real());
+                }
+
+                if (y != -1) {
+                    result[y].resize(shared.size() + others[y].size() - 1);
+                    for (size_t j = 0; j < result[y].size(); ++j) {
+                        result[y][j] = llround(f[j].imag());
+                    }
+                }
+            });
+        }
+
+        return result;
+    }
+
+private:
+    /**
+     * Per thread transform buffers
+     */
+    vector<vector<cd>> scratch;
+
+    /**
+     * Smallest power of two >= size
+     */
+    static int transform_size(int size)
+    {
+        int n = 1;
+        while (n < size) {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    /**
+     * Run f(i, scratch) for i in [0, count) across threads
+     */
+    template <class F>
+    void parallel_for(int count, F f)
+    {
+        Parallel::parallel_for(count, threads, [&](ll i, int t) {
+            f(i, scratch[t]);
+        });
+    }
+};
+
+/**
+ * Decimal digits per limb in big_multiply, 10^4 limbs keep
+ * every product coefficient below 10^8 * 2^25 < 2^63
+ */
+const int LIMB_DIGITS = 4;
+const ll LIMB = 10000;
+
+/**
+ * Below this many limbs in the shorter factor
+ * big_multiply uses schoolbook multiplication
+ */
+const int BIG_THRESHOLD = 800;
+
+/**
+ * Multiply two non-negative integers given in decimal
+ *
+ * Digits are packed little endian into base 10^4 limbs, multiplied as
+ * polynomials (schoolbook for short factors, multiply_exact otherwise)
+ * and carried back into base 10.
+ *
+ * @param x Decimal digits, optionally with a leading '-'
+ * @param y Decimal digits, optionally with a leading '-'
+ * @param threshold Schoolbook limit in limbs of the shorter factor
+ * @return x * y in decimal
+ */
+string big_multiply(string const& x, string const& y, int threshold = BIG_THRESHOLD)
+{
+    bool negative = false;
+    auto pack = [&](string const& s) {
+        size_t first = 0;
+        if (!s.empty() && s[0] == '-') {
+            negative = !negative;
+            first = 1;
+        }
+
+        vector<ll> limbs;
+        for (ll end = s.size(); end > (ll) first; end -= LIMB_DIGITS) {
+            ll begin = max<ll>(first, end - LIMB_DIGITS);
+            ll limb = 0;
+            for (ll i = begin; i < end; ++i) {
+                if (s[i] < '0' || s[i] > '9') {
+                    throw invalid_argument("not a decimal number: " + s);
+                }
+                limb = limb * 10 + (s[i] - '0');
+            }
+            limbs.push_back(limb);
+        }
+
+        return limbs;
+    };
+
+    vector<ll> a = pack(x), b = pack(y);
+    if (a.empty() || b.empty()) {
+        throw invalid_argument("empty number");
+    }
+
+    vector<ll> product;
+    if ((int) min(a.size(), b.size()) <= threshold) {
+        product.assign(a.size() + b.size() - 1, 0);
+        for (size_t i = 0; i < a.size(); ++i) {
+            for (size_t j = 0; j < b.size(); ++j) {
+                product[i + j] += a[i] * b[j];
+            }
+        }
+    } else {
+        product = multiply_exact(a, b);
+    }
+
+    // Carry
+    ll carry = 0;
+    for (ll & limb : product) {
+        limb += carry;
+        carry = limb / LIMB;
+        limb %= LIMB;
+    }
+    while (carry > 0) {
+        product.push_back(carry % LIMB);
+        carry /= LIMB;
+    }
+
+    while (product.size() > 1 && product.back() == 0) {
+        product.pop_back();
+    }
+
+    string result = to_string(product.back());
+    for (int i = (int) product.size() - 2; i >= 0; --i) {
+        string limb = to_string(product[i]);
+        result += string(LIMB_DIGITS - limb.size(), '0') + limb;
+    }
+
+    if (negative && result != "0") {
+        result = "-" + result;
     }
 
     return result;
 }
 
-int main()
+/**
+ * Time multiply and multiply_exact at degrees 10^5 to 10^7
+ */
+int bench()
+{
+    mt19937 rng(1);
+    bool ok = true;
+
+    for (int degree : {100000, 1000000, 10000000}) {
+        vector<ll> a(degree + 1), b(degree + 1);
+        for (auto & x : a) {
+            x = (ll) (rng() % 201) - 100;
+        }
+        for (auto & x : b) {
+            x = (ll) (rng() % 201) - 100;
+        }
+
+        cout << "degree " << degree << "\n";
+
+        auto start = chrono::steady_clock::now();
+        vector<ll> fast = multiply(a, b);
+        auto end = chrono::steady_clock::now();
+        cout << "  fft: " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        start = chrono::steady_clock::now();
+        vector<ll> exact = multiply_exact(a, b);
+        end = chrono::steady_clock::now();
+        cout << "  ntt (3 primes): " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        ok = ok && fast == exact;
+    }
+
+    // Coefficients near 2^23, results near 2^62, beyond what doubles hold
+    vector<ll> a(100000), b(100000);
+    for (auto & x : a) {
+        x = rng() % (1 << 23);
+    }
+    for (auto & x : b) {
+        x = rng() % (1 << 23);
+    }
+
+    vector<ll> exact = multiply_exact(a, b);
+    for (int t = 0; t < 100; ++t) {
+        int k = rng() % exact.size();
+
+        __int128 expected = 0;
+        for (int i = max(0, k - (int) b.size() + 1); i <= min(k, (int) a.size() - 1); ++i) {
+            expected += (__int128) a[i] * b[k - i];
+        }
+        ok = ok && expected == exact[k];
+    }
+
+    cout << "large coefficients, fft " << (multiply(a, b) == exact ? "exact" : "inexact") << "\n";
+
+    // Batches of 4000 polynomials of degree 1000
+    vector<vector<ll>> left(4000), right(4000);
+    for (size_t i = 0; i < left.size(); ++i) {
+        left[i].resize(1001);
+        right[i].resize(1001);
+        for (auto & x : left[i]) {
+            x = (ll) (rng() % 201) - 100;
+        }
+        for (auto & x : right[i]) {
+            x = (ll) (rng() % 201) - 100;
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<vector<ll>> single(left.size());
+    for (size_t i = 0; i < left.size(); ++i) {
+        single[i] = multiply(left[i], right[i]);
+    }
+    auto end = chrono::steady_clock::now();
+    cout << "4000 products one by one: " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+    BatchMultiplier batch;
+    start = chrono::steady_clock::now();
+    vector<vector<ll>> pairwise = batch.multiply(left, right);
+    end = chrono::steady_clock::now();
+    cout << "  batched (" << batch.threads << " threads): "
+         << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+    start = chrono::steady_clock::now();
+    vector<vector<ll>> shared = batch.multiply(left[0], right);
+    end = chrono::steady_clock::now();
+    cout << "  batched, shared operand: " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+    ok = ok && pairwise == single && shared[1] == multiply(left[0], right[1]);
+
+    auto random_digits = [&](int digits) {
+        string s;
+        for (int i = 0; i < digits; ++i) {
+            s += char('1' + rng() % 9);
+        }
+        return s;
+    };
+
+    // Big integers around the schoolbook threshold, both paths
+    for (int limbs : {BIG_THRESHOLD / 4, BIG_THRESHOLD / 2, BIG_THRESHOLD, 2 * BIG_THRESHOLD, 4 * BIG_THRESHOLD}) {
+        string x = random_digits(LIMB_DIGITS * limbs), y = random_digits(LIMB_DIGITS * limbs);
+
+        start = chrono::steady_clock::now();
+        string school = big_multiply(x, y, INT_MAX);
+        end = chrono::steady_clock::now();
+        cout << limbs << " limb integers, schoolbook: "
+             << chrono::duration<double, milli>(end - start).count() << " ms";
+
+        start = chrono::steady_clock::now();
+        string ntt = big_multiply(x, y, 0);
+        end = chrono::steady_clock::now();
+        cout << ", ntt: " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        ok = ok && school == ntt;
+
+        // Digit by digit reference at the threshold
+        if (limbs == BIG_THRESHOLD) {
+            vector<int> digits(x.size() + y.size(), 0);
+            for (size_t i = 0; i < x.size(); ++i) {
+                int carry = 0;
+                for (size_t j = 0; j < y.size(); ++j) {
+                    int & d = digits[i + j];
+                    int cur = d + (x[x.size() - 1 - i] - '0') * (y[y.size() - 1 - j] - '0') + carry;
+                    d = cur % 10;
+                    carry = cur / 10;
+                }
+                for (size_t k = i + y.size(); carry > 0; ++k) {
+                    int cur = digits[k] + carry;
+                    digits[k] = cur % 10;
+                    carry = cur / 10;
+                }
+            }
+            while (digits.size() > 1 && digits.back() == 0) {
+                digits.pop_back();
+            }
+
+            string expected;
+            for (int i = (int) digits.size() - 1; i >= 0; --i) {
+                expected += char('0' + digits[i]);
+            }
+            ok = ok && school == expected;
+        }
+    }
+
+    // Far past it, checked by casting out nines
+    string x = random_digits(1000000), y = random_digits(1000000);
+    start = chrono::steady_clock::now();
+    string product = big_multiply(x, y);
+    end = chrono::steady_clock::now();
+    cout << "1000000 digit integers: " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+    auto nines = [](string const& s) {
+        ll sum = 0;
+        for (char c : s) {
+            sum += c - '0';
+        }
+        return sum % 9;
+    };
+    ok = ok && nines(product) == nines(x) * nines(y) % 9 && product.size() >= 2 * x.size() - 1;
+
+    cout << (ok ? "ok" : "MISMATCH") << endl;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char ** argv)
 {
     cin.tie(nullptr);
     ios::sync_with_stdio(false);
 
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
+
     int T;
     int n, m;
 
@@ -138,28 +843,8 @@ int main()
         cin >> pol2[i];
     }
 
-    /*
-    From CP-Algorithms:
-
-    "It should be noted, that the two polynomials should have the same degree.
-    Otherwise the two result vectors of the DFT have different length.
-    We can accomplish this by adding coefficients with the value $0$.
-    
-    And also, since the result of the product of two polynomials is a polynomial of degree  $2 (n - 1)$, 
-    we have to double the degrees of each polynomial (again by padding  $0$ s).
-    From a vector with  $n$  values we cannot reconstruct the desired polynomial with  $2n - 1$  coefficients."
-
-    -- https://cp-algorithms.com/algebra/fft.html
-    */
-
-    int sz = (max(n, m) % 2 == 0)
-        ? max(n, m)
-        : max(n, m) + 1;
-
-    pol1.resize(sz, 0);
-    pol2.resize(sz, 0);
-
-    vector<int> result = multiply(pol1, pol2);
+    // Inputs of different degree are padded by multiply itself
+    vector<ll> result = multiply(pol1, pol2);
 
     // Drop trailing zeros
     while (result.size() > 1 && result.back() == 0) {
@@ -174,4 +859,4 @@ int main()
     cout << flush;
 
     return 0;
-}
\ No newline at end of file
+}
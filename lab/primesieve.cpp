@@ -1,5 +1,15 @@
 #include <iostream>
 #include <cstring>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <string>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <map>
 
 /**
  * @author Oskar Arensmeier
@@ -7,17 +17,35 @@
  */
 
 /**
- * Sieve of Eratosthenes implementation using a bit array.
+ * Segmented sieve of Eratosthenes over odd numbers.
  * Reference: https://cp-algorithms.com/algebra/sieve-of-eratosthenes.html
  *
  * Algorithm:
- * Start by initing the array with all bits 1.
- * Then, for each number i starting from 2,
- * if i is still marked as prime, mark all multiples of i as not prime.
- * 
- * Time complexity: O(n log log n)
+ * Only odd numbers are stored, bit k stands for 2k + 1, 2 is handled apart.
+ * First sieve the primes up to sqrt(n) with a small sieve. Then split
+ * [0, n] into segments of SEGMENT_BITS odd numbers (32 KiB, fits in L1).
+ * Each segment starts with all bits 1, and for every base prime p the odd
+ * multiples of p from p * p on are cleared (step 2p, i.e. p bits).
+ * The position reached at the end of a segment is where the next one
+ * starts, so each thread sieves a contiguous range of segments and only
+ * divides once per prime. Primes are counted with popcount per word.
  *
- * Space complexity: O(n / 8) for the bit array
+ * The bitmap (n / 16 bytes) is kept if requested, making is_prime O(1).
+ * Otherwise only the base primes are kept and is_prime falls back to
+ * trial division by them.
+ *
+ * Along with the bitmap a rank index is stored: the number of primes
+ * before every block of 8 words. pi(x) is then the block prefix plus at
+ * most 8 popcounts, and nth_prime(k) a binary search over the blocks.
+ *
+ * pi(x) past the sieve (or without the bitmap) uses Lehmer's formula,
+ * and range(a, b) enumerates the primes in [a, b] one segment at a time,
+ * independent of n.
+ *
+ * Time complexity: O(n log log n / threads)
+ *
+ * Space complexity: O(sqrt(n) + threads * segment), plus O(n / 16)
+ * when the bitmap is stored
  */
 
 using namespace std;
@@ -27,6 +55,11 @@ class PrimeSieve
 {
 public:
 
+/**
+ * Odd numbers per segment
+ */
+static constexpr ll SEGMENT_BITS = 1 << 18;
+
 /**
  * Sieve size
  */
@@ -40,33 +73,50 @@ ll m;
 /**
  * Constructor
  * @param n Sieve size
+ * @param store Keep the bitmap for is_prime
+ * @param threads Number of threads
  */
-PrimeSieve(ll n) : n(n), m(bit_count())
+PrimeSieve(ll n, bool store = true, int threads = thread::hardware_concurrency()) : n(n), m(0)
 {
     if (n < 0) {
-        invalid_argument("n must not be negative");
+        throw invalid_argument("n must not be negative");
     }
 
-    init_sieve();
+    init_base();
+    init_sieve(store, max(1, threads));
 }
 
-/**
- * Destructor
- */
-~PrimeSieve() { delete[] sieve; }
-
 /**
  * Check if i is prime
  * @param i Number to check
  * @return true if i is prime, false otherwise
  */
-bool is_prime(ll i)
+bool is_prime(ll i) const
 {
     if (i < 0 || i > n) {
         throw out_of_range("i must be in range [0, n]");
     }
 
-    return bit_is_set(i);
+    if (i < 3 || i % 2 == 0) {
+        return i == 2;
+    }
+
+    if (!sieve.empty()) {
+        return bit_is_set(sieve.data(), i / 2);
+    }
+
+    // No bitmap, trial division by the base primes (up to sqrt(n))
+    for (ll p : base) {
+        if (p * p > i) {
+            break;
+        }
+
+        if (i % p == 0) {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 /**
@@ -75,64 +125,599 @@ bool is_prime(ll i)
  */
 ll prime_count() const { return m; }
 
+/**
+ * Number of primes <= x
+ *
+ * O(1) within a stored sieve, Lehmer's formula otherwise,
+ * about O(x^(2/3)) time and memory
+ * @param x Any non-negative number
+ */
+ll pi(ll x) const
+{
+    if (x < 0) {
+        throw out_of_range("x must not be negative");
+    }
+
+    if (x <= n && !sieve.empty()) {
+        return rank(x);
+    }
+
+    return Lehmer(x, *this).count(x);
+}
+
+/**
+ * Get the k-th prime (1-based) in the sieve
+ *
+ * Time complexity: O(log n)
+ * @throws out_of_range if k is not in [1, prime_count()]
+ * @throws logic_error if the bitmap was not stored
+ */
+ll nth_prime(ll k) const
+{
+    if (k < 1 || k > m) {
+        throw out_of_range("k must be in range [1, prime_count()]");
+    }
+
+    if (sieve.empty()) {
+        throw logic_error("nth_prime needs the stored bitmap");
+    }
+
+    if (k == 1) {
+        return 2;
+    }
+
+    // Odd primes only, first block with more than k - 2 before its end
+    k -= 2;
+    ll block = upper_bound(blocks.begin(), blocks.end(), k) - blocks.begin() - 1;
+    k -= blocks[block];
+
+    ll w = block * BLOCK_WORDS;
+    while (__builtin_popcountll(sieve[w]) <= k) {
+        k -= __builtin_popcountll(sieve[w]);
+        w++;
+    }
+
+    // k-th set bit of the word
+    uint64_t word = sieve[w];
+    for (; k > 0; --k) {
+        word &= word - 1;
+    }
+
+    return 2 * (w * 64 + __builtin_ctzll(word)) + 1;
+}
+
+/**
+ * Lazy enumeration of the primes in [a, b], one segment
+ * of SEGMENT_BITS odd numbers sieved at a time
+ *
+ * Space complexity: O(sqrt(b) + segment)
+ */
+class Range
+{
+public:
+    /**
+     * Constructor
+     * @param a First number
+     * @param b Last number
+     */
+    Range(ll a, ll b) : b(max(b, 0LL)), lo(max(a, 0LL) / 2), hi(lo), w(0), word(0)
+    {
+        two = a <= 2 && 2 <= b;
+        base = odd_primes(isqrt(this->b));
+        segment.resize(SEGMENT_BITS / 64);
+        next_multiple(lo, base, multiple);
+    }
+
+    /**
+     * Get the next prime
+     * @param p Set to the prime
+     * @return false once the range is exhausted
+     */
+    bool next(ll & p)
+    {
+        if (two) {
+            two = false;
+            p = 2;
+            return true;
+        }
+
+        while (word == 0) {
+            if (++w >= word_count(hi - lo)) {
+                // Next segment
+                lo = hi;
+                hi = min((b + 1) / 2, lo + SEGMENT_BITS);
+                if (lo >= hi) {
+                    return false;
+                }
+
+                sieve_segment(segment.data(), lo, hi, base, multiple);
+                w = 0;
+            }
+
+            word = segment[w];
+        }
+
+        p = 2 * (lo + w * 64 + __builtin_ctzll(word)) + 1;
+        word &= word - 1;
+        return true;
+    }
+
 private:
+    ll b;
+    bool two;
+
+    /**
+     * Current segment, bits [lo, hi)
+     */
+    ll lo;
+    ll hi;
+    vector<uint64_t> segment;
+
+    /**
+     * Current word and its remaining bits
+     */
+    ll w;
+    uint64_t word;
+
+    vector<ll> base;
+    vector<ll> multiple;
+};
+
 /**
- * Bit array for sieve of Eratosthenes
+ * Primes in [a, b]
  */
-char * sieve;
+Range range(ll a, ll b) const { return Range(a, b); }
 
+private:
 /**
- * Initialize the sieve
+ * Words per rank block
  */
-void init_sieve()
+static constexpr ll BLOCK_WORDS = 8;
+
+/**
+ * Bit array over odd numbers, bit k is 2k + 1. Empty if not stored
+ */
+vector<uint64_t> sieve;
+
+/**
+ * Odd primes before each block of BLOCK_WORDS words
+ */
+vector<ll> blocks;
+
+/**
+ * Odd primes up to sqrt(n)
+ */
+vector<ll> base;
+
+/**
+ * Lehmer's prime counting formula
+ * reference: https://en.wikipedia.org/wiki/Prime-counting_function#Meissel%E2%80%93Lehmer_algorithm
+ *
+ * pi(x) = phi(x, a) + (b + a - 2)(b - a + 1) / 2
+ *         - sum_{a < i <= b} pi(x / p_i)
+ *         - sum_{a < i <= c} sum_{i <= j <= pi(sqrt(x / p_i))} (pi(x / p_i / p_j) - (j - 1))
+ *
+ * with a = pi(x^(1/4)), b = pi(x^(1/2)), c = pi(x^(1/3)), and phi(x, a)
+ * the count of numbers <= x not divisible by any of the first a primes.
+ * Small pi values come from a stored sieve up to about x^(2/3), larger
+ * ones recurse. phi(x, a) recurses as phi(x, a - 1) - phi(x / p_a, a - 1)
+ * down to a = 6, which is periodic in 2 * 3 * 5 * 7 * 11 * 13 = 30030.
+ */
+class Lehmer
 {
-    sieve = new char[byte_count()];
-    memset(sieve, 0xFF, byte_count());
+public:
+    static constexpr int WHEEL_PRIMES = 6;
+    static constexpr ll WHEEL = 30030;
+
+    /**
+     * Sieve to read small pi values from, either the
+     * caller's own or a new one
+     */
+    const PrimeSieve * table;
+    unique_ptr<PrimeSieve> owned;
+
+    /**
+     * Primes up to sqrt(x), 2 included
+     */
+    vector<ll> primes;
+
+    /**
+     * Numbers < i coprime to the wheel primes
+     */
+    vector<int> wheel;
 
-    // 0 and 1 are not prime
-    bit_flip(0);
-    bit_flip(1);
+    Lehmer(ll x, const PrimeSieve & sieve)
+    {
+        ll limit = max<ll>({isqrt(x) + 1, icbrt(x) * icbrt(x), 1000});
+        if (!sieve.sieve.empty() && sieve.n >= limit) {
+            table = &sieve;
+        } else {
+            owned = make_unique<PrimeSieve>(limit, true);
+            table = owned.get();
+        }
+
+        primes.push_back(2);
+        for (ll p : odd_primes(isqrt(x))) {
+            primes.push_back(p);
+        }
+
+        wheel.assign(WHEEL + 1, 0);
+        for (ll i = 0; i < WHEEL; ++i) {
+            bool coprime = i % 2 && i % 3 && i % 5 && i % 7 && i % 11 && i % 13;
+            wheel[i + 1] = wheel[i] + coprime;
+        }
+    }
+
+    /**
+     * Count numbers <= x coprime to the first a primes
+     */
+    ll phi(ll x, ll a) const
+    {
+        if (a <= WHEEL_PRIMES) {
+            return small_phi(x, a);
+        }
 
-    for (ll i = 2; i * i <= n; ++i) {
-        if (bit_is_set(i)) {
-            for (ll j = i * i; j <= n; j += i) {
-                if (bit_is_set(j)) {
-                    bit_flip(j);
+        // Only 1 and primes in (p_a, x] left, just 1 when x < p_a
+        if (a < (ll) primes.size() && primes[a] * primes[a] > x && x <= table->n) {
+            return x == 0 ? 0 : max(1LL, table->rank(x) - a + 1);
+        }
+
+        return phi(x, a - 1) - phi(x / primes[a - 1], a - 1);
+    }
+
+    /**
+     * phi for the first a <= 6 primes
+     */
+    ll small_phi(ll x, ll a) const
+    {
+        if (a == WHEEL_PRIMES) {
+            return x / WHEEL * wheel[WHEEL] + wheel[x % WHEEL + 1];
+        }
+
+        if (a == 0) {
+            return x;
+        }
+
+        return small_phi(x, a - 1) - small_phi(x / primes[a - 1], a - 1);
+    }
+
+    /**
+     * pi(x)
+     */
+    ll count(ll x) const
+    {
+        if (x <= table->n) {
+            return table->rank(x);
+        }
+
+        ll a = count(iroot4(x));
+        ll b = count(isqrt(x));
+        ll c = count(icbrt(x));
+
+        ll sum = phi(x, a) + (b + a - 2) * (b - a + 1) / 2;
+        for (ll i = a + 1; i <= b; ++i) {
+            ll w = x / primes[i - 1];
+            sum -= count(w);
+
+            if (i <= c) {
+                ll bi = count(isqrt(w));
+                for (ll j = i; j <= bi; ++j) {
+                    sum -= count(w / primes[j - 1]) - (j - 1);
                 }
             }
         }
+
+        return sum;
+    }
+};
+
+/**
+ * Primes <= x from the stored bitmap
+ */
+ll rank(ll x) const
+{
+    if (x < 2) {
+        return 0;
+    }
+
+    // Odd numbers <= x are bits [0, k)
+    ll k = (x + 1) / 2;
+    ll w = k / 64;
+    ll count = 1 + blocks[w / BLOCK_WORDS];
+
+    for (ll i = w / BLOCK_WORDS * BLOCK_WORDS; i < w; ++i) {
+        count += __builtin_popcountll(sieve[i]);
+    }
+
+    if (k % 64 != 0) {
+        count += __builtin_popcountll(sieve[w] & ((1ULL << (k % 64)) - 1));
+    }
+
+    return count;
+}
+
+/**
+ * Floor of sqrt(x)
+ */
+static ll isqrt(ll x)
+{
+    ll r = sqrtl(x);
+    while (r * r > x) {
+        r--;
+    }
+    while ((r + 1) * (r + 1) <= x) {
+        r++;
+    }
+    return r;
+}
+
+/**
+ * Floor of x^(1/3)
+ */
+static ll icbrt(ll x)
+{
+    ll r = cbrtl(x);
+    while (r * r * r > x) {
+        r--;
+    }
+    while ((r + 1) * (r + 1) * (r + 1) <= x) {
+        r++;
+    }
+    return r;
+}
+
+/**
+ * Floor of x^(1/4)
+ */
+static ll iroot4(ll x)
+{
+    return isqrt(isqrt(x));
+}
+
+/**
+ * Odd primes up to limit, simple sieve
+ */
+static vector<ll> odd_primes(ll limit)
+{
+    vector<ll> primes;
+    vector<char> composite(limit + 1, false);
+    for (ll i = 3; i <= limit; i += 2) {
+        if (composite[i]) {
+            continue;
+        }
+
+        primes.push_back(i);
+        for (ll j = i * i; j <= limit; j += 2 * i) {
+            composite[j] = true;
+        }
+    }
+
+    return primes;
+}
+
+/**
+ * First bit to clear for each base prime in a segment starting at bit lo
+ */
+static void next_multiple(ll lo, const vector<ll> & base, vector<ll> & next)
+{
+    next.resize(base.size());
+    for (size_t i = 0; i < base.size(); ++i) {
+        ll p = base[i];
+        ll start = max(p * p, (2 * lo + 1 + p - 1) / p * p);
+        if (start % 2 == 0) {
+            start += p;
+        }
+        next[i] = start / 2;
+    }
+}
+
+/**
+ * Sieve bits [lo, hi) into seg, next holds the first bit to clear for
+ * each base prime and is advanced past hi
+ */
+static void sieve_segment(uint64_t * seg, ll lo, ll hi, const vector<ll> & base, vector<ll> & next)
+{
+    ll words = word_count(hi - lo);
+    memset(seg, 0xFF, words * sizeof(uint64_t));
+
+    for (size_t i = 0; i < base.size(); ++i) {
+        ll p = base[i];
+        ll k = next[i];
+        for (; k < hi; k += p) {
+            bit_clear(seg, k - lo);
+        }
+        next[i] = k;
+    }
+
+    // 1 is not prime
+    if (lo == 0) {
+        bit_clear(seg, 0);
+    }
+
+    // Bits past the end
+    if ((hi - lo) % 64 != 0) {
+        seg[words - 1] &= (1ULL << ((hi - lo) % 64)) - 1;
+    }
+}
+
+/**
+ * Sieve the odd primes up to sqrt(n)
+ */
+void init_base()
+{
+    base = odd_primes(isqrt(n));
+}
+
+/**
+ * Initialize the sieve
+ */
+void init_sieve(bool store, int threads)
+{
+    // Odd numbers 1, 3, .., up to n
+    ll bits = (n + 1) / 2;
+    ll segments = (bits + SEGMENT_BITS - 1) / SEGMENT_BITS;
+    threads = (int) min<ll>(threads, max<ll>(1, segments));
+
+    if (store) {
+        sieve.assign(word_count(bits), 0);
+    }
+
+    vector<ll> count(threads, 0);
+    auto worker = [&](int t) {
+        ll first = segments * t / threads;
+        ll last = segments * (t + 1) / threads;
+
+        vector<uint64_t> local;
+        if (!store) {
+            local.resize(SEGMENT_BITS / 64);
+        }
+
+        // Next bit to clear for each base prime
+        vector<ll> next;
+        next_multiple(first * SEGMENT_BITS, base, next);
+
+        for (ll s = first; s < last; ++s) {
+            ll lo = s * SEGMENT_BITS;
+            ll hi = min(bits, lo + SEGMENT_BITS);
+            uint64_t * seg = store ? sieve.data() + lo / 64 : local.data();
+
+            sieve_segment(seg, lo, hi, base, next);
+
+            for (ll w = 0; w < word_count(hi - lo); ++w) {
+                count[t] += __builtin_popcountll(seg[w]);
+            }
+        }
+    };
+
+    vector<thread> pool;
+    for (int t = 1; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+
+    for (auto & th : pool) {
+        th.join();
+    }
+
+    // 2 is the only even prime
+    m = n >= 2 ? 1 : 0;
+    for (ll c : count) {
+        m += c;
+    }
+
+    if (store) {
+        init_rank();
+    }
+}
+
+/**
+ * Prefix popcounts per block of BLOCK_WORDS words
+ */
+void init_rank()
+{
+    ll count = (ll) sieve.size() / BLOCK_WORDS + 1;
+    blocks.assign(count, 0);
+
+    for (ll i = 1; i < count; ++i) {
+        blocks[i] = blocks[i - 1];
+        for (ll w = (i - 1) * BLOCK_WORDS; w < i * BLOCK_WORDS; ++w) {
+            blocks[i] += __builtin_popcountll(sieve[w]);
+        }
     }
 }
 
-/** Returns the number of bytes in sieve */
-inline ll byte_count() { return n / 8 + 1; }
-/** Returns the number of bits in sieve */
-inline ll bit_count()  { return n + 1; }
+/** Returns the number of words holding the given number of bits */
+static inline ll word_count(ll bits) { return (bits + 63) / 64; }
 
 /**
- * Flip bit i in sieve.
+ * Clear bit i in sieve.
  */
-inline void bit_flip(ll i)
+static inline void bit_clear(uint64_t * sieve, ll i)
 {
-    m --;
-    sieve[i / 8] = sieve[i / 8] ^ (1 << (i % 8));
+    sieve[i / 64] &= ~(1ULL << (i % 64));
 }
 
 /**
  * Check if bit i in sieve is set.
  */
-inline bool bit_is_set(ll i)
+static inline bool bit_is_set(const uint64_t * sieve, ll i)
 {
-    return (sieve[i / 8] & (1 << (i % 8))) != 0;
+    return (sieve[i / 64] >> (i % 64)) & 1;
 }
 };
 
+/**
+ * Time sieving to increasing n, with and without the stored bitmap
+ */
+int bench()
+{
+    // Known values of pi(n)
+    map<ll, ll> expected = {
+        {100000000LL, 5761455},
+        {1000000000LL, 50847534},
+        {10000000000LL, 455052511},
+        {1000000000000LL, 37607912018LL},
+    };
+    bool ok = true;
+
+    for (ll n : {100000000LL, 1000000000LL, 10000000000LL}) {
+        for (bool store : {true, false}) {
+            // The stored bitmap at 10^10 is 625 MB
+            if (store && n > 1000000000LL) {
+                continue;
+            }
+
+            auto start = chrono::steady_clock::now();
+            PrimeSieve ps(n, store);
+            auto end = chrono::steady_clock::now();
+
+            cout << "n = " << n << (store ? ", stored" : ", count only")
+                 << ": pi(n) = " << ps.prime_count() << ", "
+                 << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+            ok = ok && ps.prime_count() == expected[n];
+        }
+    }
 
-int main()
+    PrimeSieve small(100);
+    for (ll x : {10000000000LL, 1000000000000LL}) {
+        auto start = chrono::steady_clock::now();
+        ll count = small.pi(x);
+        auto end = chrono::steady_clock::now();
+
+        cout << "Lehmer pi(" << x << ") = " << count << ", "
+             << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        ok = ok && count == expected[x];
+    }
+
+    ll a = 1000000000000LL, b = a + 100000000LL, count = 0, p;
+    auto start = chrono::steady_clock::now();
+    for (auto r = small.range(a, b); r.next(p);) {
+        count++;
+    }
+    auto end = chrono::steady_clock::now();
+
+    cout << "range [" << a << ", " << b << "]: " << count << " primes, "
+         << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+    // a itself is even, so pi(b) - pi(a) counts the same primes
+    ok = ok && count == small.pi(b) - small.pi(a);
+
+    cout << (ok ? "ok" : "MISMATCH") << endl;
+    return ok ? 0 : 1;
+}
+
+
+int main(int argc, char ** argv)
 {
     cin.tie(nullptr);
     cin.sync_with_stdio(false);
 
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
+
     ll n, q;
     cin >> n >> q;
 
@@ -148,4 +733,4 @@ int main()
 
     cout << flush;
     return 0;
-}
\ No newline at end of file
+}
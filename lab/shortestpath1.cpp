@@ -2,6 +2,16 @@
 #include <vector>
 #include <limits>
 #include <queue>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <unordered_set>
+#include <fstream>
+#include <filesystem>
 
 /**
  * @author Oskar Arensmeier
@@ -41,6 +51,37 @@
  *
  * - Adjacency list using vectors
  * - Priority queue for the Dijkstra's algorithm
+ *
+ *
+ * CSR engine:
+ *
+ * CSRDijkstra runs the same algorithm over a CSR graph (offsets plus packed
+ * (v, w) arcs) with 64-bit distances, and takes its priority queue as a
+ * template parameter:
+ *
+ * - BinaryHeap      O((n + m) log n), lazy deletion
+ * - QuaternaryHeap  O(m + n log n) comparisons in practice, decrease-key,
+ *                   at most n entries
+ * - RadixHeap       O(m + n log C), C max weight, monotone keys only
+ * - DialQueue       O(m + D), D max distance, for small integer weights
+ *
+ * Run with 'bench' as the first argument to compare them on generated
+ * grid and random graphs.
+ *
+ *
+ * Query engine:
+ *
+ * QueryEngine owns one graph and answers many (start, end) queries:
+ * bidirectional Dijkstra for single queries, and a batch mode that groups
+ * queries by start node and spreads the groups over a pool of threads.
+ * Search buffers are stamped with a search number, so a new query does not
+ * pay O(n) to reset them.
+ *
+ * For static graphs, ContractionHierarchy preprocesses the graph once
+ * (shortcuts + node ranks, saved to / loaded from a binary file) so each
+ * query only explores a small upward search space. Its shortest_path()
+ * unpacks shortcuts and returns a node list in the same format as
+ * Dijkstra's, a shortest path from start to end.
  */
 
 using namespace std;
@@ -234,10 +275,1715 @@ public:
     }
 };
 
-int main()
+/**
+ * Graph in compressed sparse row form
+ *
+ * Out arcs of u are arcs[offset[u]] .. arcs[offset[u+1] - 1],
+ * packed (v, w) pairs so a node expansion is one linear scan.
+ */
+class CSRGraph
 {
-    cin.sync_with_stdio(false);
-    cin.tie(nullptr);
+public:
+
+    /**
+     * Packed arc
+     */
+    struct Arc
+    {
+        int v;
+        int w;
+    };
+
+    /**
+     * Node count
+     */
+    int N;
+
+    /**
+     * Arcs of u are [offset[u], offset[u+1])
+     */
+    vector<int> offset;
+
+    /**
+     * All arcs, grouped by source node
+     */
+    vector<Arc> arcs;
+
+    /**
+     * Largest arc weight
+     */
+    int max_weight = 0;
+
+    /**
+     * Constructor, empty graph
+     * @param n Number nodes
+     */
+    CSRGraph(int n) : N(n), offset(n + 1, 0) {}
+
+    /**
+     * Constructor
+     * @param G Graph to lay out
+     */
+    CSRGraph(const Graph & G) : N(G.N)
+    {
+        offset.assign(N + 1, 0);
+        for (int u = 0; u < N; ++u) {
+            offset[u + 1] = offset[u] + G.adj[u].size();
+        }
+
+        arcs.reserve(offset[N]);
+        for (int u = 0; u < N; ++u) {
+            for (auto & e : G.adj[u]) {
+                arcs.push_back({e.v, e.w});
+                max_weight = max(max_weight, e.w);
+            }
+        }
+    }
+};
+
+/**
+ * Infinite 64-bit distance
+ */
+const ll DIST_INF = numeric_limits<ll>::max();
+
+/*
+ * Priority queues for CSRDijkstra
+ *
+ * All of them share the same interface:
+ * - init(n, max_weight) prepare for nodes [0, n) and arcs of at most max_weight
+ * - push(u, d) insert u with key d, or lower its key
+ * - empty()
+ * - pop() remove and return {key, node} with the smallest key
+ *
+ * Lazy queues may hand out stale entries, CSRDijkstra skips any
+ * entry whose key is larger than the node's current distance.
+ */
+
+/**
+ * Binary heap (std::priority_queue) with lazy deletion
+ */
+class BinaryHeap
+{
+public:
+
+    void init(int n, int max_weight)
+    {
+        pq = {};
+    }
+
+    void push(int u, ll d)
+    {
+        pq.push({d, u});
+    }
+
+    bool empty() const
+    {
+        return pq.empty();
+    }
+
+    pair<ll, int> pop()
+    {
+        auto top = pq.top();
+        pq.pop();
+        return top;
+    }
+
+private:
+    priority_queue<
+        pair<ll, int>,
+        vector<pair<ll, int>>,
+        greater<pair<ll, int>>
+    > pq;
+};
+
+/**
+ * Indexed 4-ary heap with decrease-key
+ *
+ * Every node is in the heap at most once, pos[u] is its index
+ * in the heap array. A 4-ary heap is shallower than a binary heap
+ * and the four children share a cache line.
+ */
+class QuaternaryHeap
+{
+public:
+
+    void init(int n, int max_weight)
+    {
+        heap.clear();
+        key.assign(n, DIST_INF);
+        pos.assign(n, -1);
+    }
+
+    void push(int u, ll d)
+    {
+        if (pos[u] == -1) {
+            pos[u] = heap.size();
+            heap.push_back(u);
+        }
+
+        key[u] = d;
+        sift_up(pos[u]);
+    }
+
+    bool empty() const
+    {
+        return heap.empty();
+    }
+
+    pair<ll, int> pop()
+    {
+        int u = heap[0];
+        pos[u] = -1;
+
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            pos[last] = 0;
+            sift_down(0);
+        }
+
+        return {key[u], u};
+    }
+
+private:
+    vector<int> heap;
+    vector<ll> key;
+    vector<int> pos;
+
+    void sift_up(int i)
+    {
+        int u = heap[i];
+        while (i > 0) {
+            int p = (i - 1) / 4;
+            if (key[heap[p]] <= key[u]) {
+                break;
+            }
+
+            heap[i] = heap[p];
+            pos[heap[i]] = i;
+            i = p;
+        }
+
+        heap[i] = u;
+        pos[u] = i;
+    }
+
+    void sift_down(int i)
+    {
+        int u = heap[i];
+        int n = heap.size();
+        while (true) {
+            int first = 4 * i + 1;
+            if (first >= n) {
+                break;
+            }
+
+            int best = first;
+            int last = min(first + 4, n);
+            for (int c = first + 1; c < last; ++c) {
+                if (key[heap[c]] < key[heap[best]]) {
+                    best = c;
+                }
+            }
+
+            if (key[heap[best]] >= key[u]) {
+                break;
+            }
+
+            heap[i] = heap[best];
+            pos[heap[i]] = i;
+            i = best;
+        }
+
+        heap[i] = u;
+        pos[u] = i;
+    }
+};
+
+/**
+ * Radix heap (monotone) with lazy deletion
+ *
+ * Keys popped never decrease, so a key k is stored in bucket
+ * "index of highest bit where k differs from the last popped key".
+ * Popping from an empty bucket 0 redistributes the first non-empty
+ * bucket around its minimum, each entry moves down O(log C) times.
+ */
+class RadixHeap
+{
+public:
+
+    void init(int n, int max_weight)
+    {
+        for (auto & b : buckets) {
+            b.clear();
+        }
+
+        last = 0;
+        size = 0;
+    }
+
+    void push(int u, ll d)
+    {
+        buckets[bucket(d)].push_back({d, u});
+        size++;
+    }
+
+    bool empty() const
+    {
+        return size == 0;
+    }
+
+    pair<ll, int> pop()
+    {
+        if (buckets[0].empty()) {
+            int i = 1;
+            while (buckets[i].empty()) {
+                i++;
+            }
+
+            ll lo = DIST_INF;
+            for (auto & [d, u] : buckets[i]) {
+                lo = min(lo, d);
+            }
+
+            last = lo;
+            for (auto & entry : buckets[i]) {
+                buckets[bucket(entry.first)].push_back(entry);
+            }
+            buckets[i].clear();
+        }
+
+        auto top = buckets[0].back();
+        buckets[0].pop_back();
+        size--;
+
+        return top;
+    }
+
+private:
+    vector<pair<ll, int>> buckets[65];
+    ll last;
+    ll size;
+
+    int bucket(ll d) const
+    {
+        return d == last ? 0 : 64 - __builtin_clzll(d ^ last);
+    }
+};
+
+/**
+ * Dial's algorithm, circular array of max_weight + 1 buckets
+ *
+ * All keys in the queue lie in [current, current + max_weight],
+ * so bucket d % (max_weight + 1) is unambiguous. Pop scans forward
+ * to the next non-empty bucket. Only suited for small integer weights.
+ */
+class DialQueue
+{
+public:
+
+    void init(int n, int max_weight)
+    {
+        buckets.assign(max_weight + 1, {});
+        current = 0;
+        size = 0;
+    }
+
+    void push(int u, ll d)
+    {
+        buckets[d % buckets.size()].push_back(u);
+        size++;
+    }
+
+    bool empty() const
+    {
+        return size == 0;
+    }
+
+    pair<ll, int> pop()
+    {
+        while (buckets[current % buckets.size()].empty()) {
+            current++;
+        }
+
+        auto & b = buckets[current % buckets.size()];
+        int u = b.back();
+        b.pop_back();
+        size--;
+
+        return {current, u};
+    }
+
+private:
+    vector<vector<int>> buckets;
+    ll current;
+    ll size;
+};
+
+/**
+ * Dijkstra's algorithm over a CSR graph
+ * with 64-bit distances and a pluggable queue
+ *
+ * @tparam Queue BinaryHeap, QuaternaryHeap, RadixHeap or DialQueue
+ */
+template <class Queue>
+class CSRDijkstra
+{
+public:
+
+    /**
+     * Graph
+     */
+    const CSRGraph & G;
+
+    /**
+     * Distance from start to each node
+     */
+    vector<ll> dist;
+
+    /**
+     * Previous node in the path
+     */
+    vector<int> prev;
+
+    /**
+     * Start node
+     */
+    int start;
+
+    /**
+     * Constructor
+     * @param G Graph
+     * @param start Start node
+     */
+    CSRDijkstra(const CSRGraph & G, int start) : G(G), start(start)
+    {
+        dist.resize(G.N, DIST_INF);
+        prev.resize(G.N, -1);
+    }
+
+    /**
+     * Run Dijkstra's algorithm
+     */
+    void run()
+    {
+        Queue pq;
+        pq.init(G.N, G.max_weight);
+
+        dist[start] = 0;
+        pq.push(start, 0);
+
+        while (!pq.empty()) {
+            auto [d, u] = pq.pop();
+
+            // Skip if we've already seen a shorter path
+            if (d > dist[u]) {
+                continue;
+            }
+
+            for (int i = G.offset[u]; i < G.offset[u + 1]; ++i) {
+                auto & e = G.arcs[i];
+                ll alt = d + e.w;
+
+                if (alt < dist[e.v]) {
+                    dist[e.v] = alt;
+                    prev[e.v] = u;
+                    pq.push(e.v, alt);
+                }
+            }
+        }
+    }
+
+    /**
+     * Get shortest path from start to end
+     *
+     * @param end End node
+     * @return Vector path
+     * @throws std::runtime_error if no path exists
+     */
+    vector<int> shortest_path(int end) const
+    {
+        vector<int> path;
+        for (int v = end; v != -1; v = prev[v]) {
+            path.push_back(v);
+        }
+        reverse(path.begin(), path.end());
+
+        // This means that start and end
+        // nodes are not connected
+        if (path.size() == 0 || path[0] != start) {
+            throw std::runtime_error("No path found");
+        }
+
+        return path;
+    }
+
+    /**
+     * Get distance from start to end
+     *
+     * @param end End node
+     * @return Distance
+     * @note Returns DIST_INF if no path exists
+     */
+    ll get_distance(int end) const
+    {
+        return dist[end];
+    }
+};
+
+/**
+ * Point-to-point query engine over one fixed graph
+ *
+ * Owns the graph (and its reverse) once and answers many
+ * (start, end) queries against it:
+ *
+ * - query() runs bidirectional Dijkstra, stopping as soon as the two
+ *   frontiers can no longer improve the best meeting point.
+ * - batch() groups queries by start node. A group with one end node is a
+ *   bidirectional query, a larger group is one Dijkstra from the start that
+ *   stops once every end node is settled. Groups are handed out to a pool
+ *   of threads, each with its own search buffers.
+ *
+ * Search buffers are versioned: every entry carries the number of the
+ * search that wrote it, so starting a new search is O(1) instead of
+ * resetting O(n) distances.
+ */
+class QueryEngine
+{
+public:
+
+    /**
+     * Distances, previous nodes and queue of one search direction
+     */
+    class SearchSpace
+    {
+    public:
+
+        /**
+         * Start a new search, invalidating all entries
+         */
+        void reset(int n)
+        {
+            if (seen.size() != n) {
+                dist.assign(n, DIST_INF);
+                prev.assign(n, -1);
+                seen.assign(n, 0);
+                version = 0;
+            }
+
+            // Wrapped around, old stamps could match again
+            if (++version == 0) {
+                fill(seen.begin(), seen.end(), 0);
+                version = 1;
+            }
+
+            heap.clear();
+        }
+
+        /**
+         * Distance of u in the current search
+         */
+        ll get(int u) const
+        {
+            return seen[u] == version ? dist[u] : DIST_INF;
+        }
+
+        /**
+         * Previous node of u in the current search
+         */
+        int parent(int u) const
+        {
+            return seen[u] == version ? prev[u] : -1;
+        }
+
+        /**
+         * Lower distance of u and queue it
+         */
+        void set(int u, ll d, int p)
+        {
+            seen[u] = version;
+            dist[u] = d;
+            prev[u] = p;
+
+            heap.push_back({d, u});
+            push_heap(heap.begin(), heap.end(), greater<pair<ll, int>>());
+        }
+
+        /**
+         * Smallest key in the queue, DIST_INF if empty
+         */
+        ll top() const
+        {
+            return heap.empty() ? DIST_INF : heap.front().first;
+        }
+
+        /**
+         * Pop the smallest entry
+         */
+        pair<ll, int> pop()
+        {
+            pop_heap(heap.begin(), heap.end(), greater<pair<ll, int>>());
+            auto top = heap.back();
+            heap.pop_back();
+            return top;
+        }
+
+        bool empty() const
+        {
+            return heap.empty();
+        }
+
+    private:
+        vector<ll> dist;
+        vector<int> prev;
+        vector<unsigned> seen;
+        unsigned version = 0;
+
+        /**
+         * Binary heap of {distance, node}, lazy deletion
+         */
+        vector<pair<ll, int>> heap;
+    };
+
+    /**
+     * Buffers owned by one thread
+     */
+    class Workspace
+    {
+    public:
+        SearchSpace forward;
+        SearchSpace backward;
+    };
+
+    /**
+     * Graph
+     */
+    CSRGraph G;
+
+    /**
+     * Reverse graph, for backward searches
+     */
+    CSRGraph R;
+
+    /**
+     * Constructor
+     * @param G Graph
+     */
+    QueryEngine(const Graph & G) : G(G), R(G.N)
+    {
+        R.offset.assign(R.N + 1, 0);
+        for (auto & e : this->G.arcs) {
+            R.offset[e.v + 1]++;
+        }
+        for (int v = 0; v < R.N; ++v) {
+            R.offset[v + 1] += R.offset[v];
+        }
+
+        R.arcs.resize(this->G.arcs.size());
+        R.max_weight = this->G.max_weight;
+        vector<int> pos(R.offset.begin(), R.offset.end() - 1);
+        for (int u = 0; u < R.N; ++u) {
+            for (int i = this->G.offset[u]; i < this->G.offset[u + 1]; ++i) {
+                auto & e = this->G.arcs[i];
+                R.arcs[pos[e.v]++] = {u, e.w};
+            }
+        }
+    }
+
+    /**
+     * Shortest distance from start to end
+     *
+     * @note Not thread safe, uses the engine's own buffers
+     * @return Distance, DIST_INF if no path exists
+     */
+    ll query(int start, int end)
+    {
+        return bidirectional(start, end, local).first;
+    }
+
+    /**
+     * Shortest path from start to end
+     *
+     * @return Vector path
+     * @throws std::runtime_error if no path exists
+     */
+    vector<int> shortest_path(int start, int end)
+    {
+        int meet = bidirectional(start, end, local).second;
+        if (meet == -1) {
+            throw std::runtime_error("No path found");
+        }
+
+        vector<int> path;
+        for (int v = meet; v != -1; v = local.forward.parent(v)) {
+            path.push_back(v);
+        }
+        reverse(path.begin(), path.end());
+
+        for (int v = local.backward.parent(meet); v != -1; v = local.backward.parent(v)) {
+            path.push_back(v);
+        }
+
+        return path;
+    }
+
+    /**
+     * Answer many queries using a pool of threads
+     *
+     * @param queries List of {start, end}
+     * @param threads Number of threads
+     * @return Distance of each query, DIST_INF if no path exists
+     */
+    vector<ll> batch(const vector<pair<int, int>> & queries, int threads = thread::hardware_concurrency())
+    {
+        vector<ll> answers(queries.size(), DIST_INF);
+
+        // Query indices grouped by start node
+        vector<int> order(queries.size());
+        for (int i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        sort(order.begin(), order.end(), [&](int a, int b) {
+            return queries[a].first < queries[b].first;
+        });
+
+        vector<pair<int, int>> groups;
+        for (int i = 0; i < order.size(); ) {
+            int j = i;
+            while (j < order.size() && queries[order[j]].first == queries[order[i]].first) {
+                j++;
+            }
+
+            groups.push_back({i, j});
+            i = j;
+        }
+
+        atomic<int> next = 0;
+        auto worker = [&]() {
+            Workspace ws;
+            vector<int> targets;
+
+            for (int g = next++; g < groups.size(); g = next++) {
+                auto [lo, hi] = groups[g];
+                int start = queries[order[lo]].first;
+
+                if (hi - lo == 1) {
+                    answers[order[lo]] = bidirectional(start, queries[order[lo]].second, ws).first;
+                    continue;
+                }
+
+                targets.clear();
+                for (int i = lo; i < hi; ++i) {
+                    targets.push_back(queries[order[i]].second);
+                }
+
+                one_to_many(start, targets, ws.forward);
+                for (int i = lo; i < hi; ++i) {
+                    answers[order[i]] = ws.forward.get(queries[order[i]].second);
+                }
+            }
+        };
+
+        threads = max(1, min<int>(threads, groups.size()));
+        vector<thread> pool;
+        for (int t = 1; t < threads; ++t) {
+            pool.emplace_back(worker);
+        }
+        worker();
+
+        for (auto & th : pool) {
+            th.join();
+        }
+
+        return answers;
+    }
+
+private:
+    /**
+     * Buffers for single queries
+     */
+    Workspace local;
+
+    /**
+     * Bidirectional Dijkstra
+     *
+     * @return {distance, meeting node}, meeting node -1 if no path
+     */
+    pair<ll, int> bidirectional(int start, int end, Workspace & ws)
+    {
+        SearchSpace & F = ws.forward;
+        SearchSpace & B = ws.backward;
+        F.reset(G.N);
+        B.reset(G.N);
+
+        F.set(start, 0, -1);
+        B.set(end, 0, -1);
+
+        ll best = start == end ? 0 : DIST_INF;
+        int meet = start == end ? start : -1;
+
+        // Neither side can beat best once the
+        // sum of the two smallest keys reaches it
+        while (!F.empty() && !B.empty() && F.top() + B.top() < best) {
+            bool forward = F.top() <= B.top();
+            SearchSpace & X = forward ? F : B;
+            SearchSpace & Y = forward ? B : F;
+            const CSRGraph & H = forward ? G : R;
+
+            auto [d, u] = X.pop();
+            if (d > X.get(u)) {
+                continue;
+            }
+
+            for (int i = H.offset[u]; i < H.offset[u + 1]; ++i) {
+                auto & e = H.arcs[i];
+                ll alt = d + e.w;
+                if (alt >= X.get(e.v)) {
+                    continue;
+                }
+
+                X.set(e.v, alt, u);
+
+                ll other = Y.get(e.v);
+                if (other != DIST_INF && alt + other < best) {
+                    best = alt + other;
+                    meet = e.v;
+                }
+            }
+        }
+
+        return {best, meet};
+    }
+
+    /**
+     * Dijkstra from start, stopping once all targets are settled
+     */
+    void one_to_many(int start, const vector<int> & targets, SearchSpace & S)
+    {
+        S.reset(G.N);
+        S.set(start, 0, -1);
+
+        // Unsettled targets, each counted once
+        unordered_set<int> left(targets.begin(), targets.end());
+
+        while (!S.empty() && !left.empty()) {
+            auto [d, u] = S.pop();
+            if (d > S.get(u)) {
+                continue;
+            }
+
+            left.erase(u);
+
+            for (int i = G.offset[u]; i < G.offset[u + 1]; ++i) {
+                auto & e = G.arcs[i];
+                ll alt = d + e.w;
+                if (alt < S.get(e.v)) {
+                    S.set(e.v, alt, u);
+                }
+            }
+        }
+    }
+};
+
+/**
+ * Contraction hierarchy for static graphs
+ * reference: R. Geisberger et al., "Contraction Hierarchies: Faster and
+ * Simpler Hierarchical Routing in Road Networks", 2008
+ *
+ * Preprocessing contracts nodes one by one, cheapest first. Contracting v
+ * removes it from the graph and, for every in-neighbor u and out-neighbor w,
+ * adds a shortcut u -> w of weight w(u, v) + w(v, w) unless a witness search
+ * (bounded Dijkstra from u avoiding v) finds a path that is at least as short.
+ * The order in which nodes are contracted is their rank.
+ *
+ * Node order uses the edge difference (shortcuts added minus arcs removed)
+ * plus the number of already contracted neighbors, to spread contraction
+ * evenly. After each contraction the priorities of the remaining neighbors
+ * are recomputed (low degree ones, see UPDATE_LIMIT), and a popped node is
+ * still re-evaluated and pushed back if it is no longer the cheapest.
+ * Witness searches shrink their bound as targets settle and stop once all
+ * targets are settled.
+ *
+ * A query is a bidirectional Dijkstra where the forward search only follows
+ * arcs to higher ranks and the backward search only follows arcs from higher
+ * ranks. Both meet at the highest ranked node of some shortest path, so
+ * only a tiny part of the graph is explored. Shortcuts remember the two arcs
+ * they replace, and are unpacked recursively to recover the original path.
+ *
+ * The hierarchy can be saved to and loaded from a binary file, skipping
+ * preprocessing on startup.
+ */
+class ContractionHierarchy
+{
+public:
+
+    /**
+     * Original arc or shortcut
+     */
+    class Arc
+    {
+    public:
+        int from;
+        int to;
+        ll w;
+
+        /**
+         * Arcs replaced by this shortcut (from -> mid -> to),
+         * -1 for original arcs
+         */
+        int first;
+        int second;
+    };
+
+    /**
+     * Max nodes settled by one witness search, a search hitting
+     * the limit adds the shortcut (never wrong, only slower).
+     * Priority estimates use a smaller limit.
+     */
+    static constexpr int WITNESS_LIMIT = 500;
+    static constexpr int ESTIMATE_LIMIT = 50;
+
+    /**
+     * Neighbors with more in x out arc pairs than this are not
+     * re-simulated after each contraction, only re-checked when
+     * popped. In the dense top of the hierarchy every contraction
+     * would otherwise cost O(degree^3) simulated shortcuts.
+     */
+    static constexpr size_t UPDATE_LIMIT = 16;
+
+    /**
+     * Node count
+     */
+    int N = 0;
+
+    /**
+     * Contraction order of each node
+     */
+    vector<int> rank;
+
+    /**
+     * All arcs and shortcuts
+     */
+    vector<Arc> arcs;
+
+    /**
+     * Arcs u -> v with rank[v] > rank[u] are up[up_offset[u] ..]
+     */
+    vector<int> up_offset;
+    vector<int> up;
+
+    /**
+     * Arcs u -> v with rank[u] > rank[v] are down[down_offset[v] ..]
+     */
+    vector<int> down_offset;
+    vector<int> down;
+
+    /**
+     * Empty hierarchy, see load()
+     */
+    ContractionHierarchy() {}
+
+    /**
+     * Build the hierarchy
+     * @param G Graph
+     */
+    ContractionHierarchy(const Graph & G) : N(G.N)
+    {
+        out_arcs.assign(N, {});
+        in_arcs.assign(N, {});
+        contracted.assign(N, false);
+        contracted_neighbors.assign(N, 0);
+        is_target.assign(N, false);
+        rank.assign(N, -1);
+
+        // Original arcs, keeping only the
+        // lightest of parallel arcs
+        for (int u = 0; u < N; ++u) {
+            for (auto & e : G.adj[u]) {
+                if (e.v != u) {
+                    add_arc(u, e.v, e.w, -1, -1);
+                }
+            }
+        }
+
+        priority_queue<
+            pair<int, int>,
+            vector<pair<int, int>>,
+            greater<pair<int, int>>
+        > pq;
+
+        // Latest priority of each node, older queue entries are skipped
+        vector<int> current(N);
+        for (int v = 0; v < N; ++v) {
+            current[v] = priority(v);
+            pq.push({current[v], v});
+        }
+
+        vector<vector<int>> up_lists(N);
+        vector<vector<int>> down_lists(N);
+        vector<int> neighbors;
+
+        int next_rank = 0;
+        while (!pq.empty()) {
+            auto [q, v] = pq.top();
+            pq.pop();
+
+            if (contracted[v] || q != current[v]) {
+                continue;
+            }
+
+            // Lazy update, only contract if still the cheapest
+            int p = priority(v);
+            if (!pq.empty() && p > pq.top().first) {
+                current[v] = p;
+                pq.push({p, v});
+                continue;
+            }
+
+            // Remaining arcs of v all lead to higher ranks
+            for (int a : out_arcs[v]) {
+                if (!contracted[arcs[a].to]) {
+                    up_lists[v].push_back(a);
+                    contracted_neighbors[arcs[a].to]++;
+                }
+            }
+            for (int a : in_arcs[v]) {
+                if (!contracted[arcs[a].from]) {
+                    down_lists[v].push_back(a);
+                    contracted_neighbors[arcs[a].from]++;
+                }
+            }
+
+            contract(v, false);
+            contracted[v] = true;
+            rank[v] = next_rank++;
+
+            // Drop arcs of v from the remaining graph
+            for (int a : out_arcs[v]) {
+                erase_arc(in_arcs[arcs[a].to], a);
+            }
+            for (int a : in_arcs[v]) {
+                erase_arc(out_arcs[arcs[a].from], a);
+            }
+            out_arcs[v].clear();
+            in_arcs[v].clear();
+
+            // Neighbors lost an arc and may have gained shortcuts
+            neighbors.clear();
+            for (int a : up_lists[v]) {
+                neighbors.push_back(arcs[a].to);
+            }
+            for (int a : down_lists[v]) {
+                neighbors.push_back(arcs[a].from);
+            }
+            sort(neighbors.begin(), neighbors.end());
+            neighbors.erase(unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+            for (int w : neighbors) {
+                if (in_arcs[w].size() * out_arcs[w].size() > UPDATE_LIMIT) {
+                    continue;
+                }
+
+                current[w] = priority(w);
+                pq.push({current[w], w});
+            }
+        }
+
+        to_csr(up_lists, up_offset, up);
+        to_csr(down_lists, down_offset, down);
+
+        out_arcs = {};
+        in_arcs = {};
+        contracted = {};
+        contracted_neighbors = {};
+        is_target = {};
+        targets = {};
+    }
+
+    /**
+     * Shortest distance from start to end
+     * @return Distance, DIST_INF if no path exists
+     */
+    ll query(int start, int end)
+    {
+        return search(start, end).first;
+    }
+
+    /**
+     * Shortest path from start to end, shortcuts unpacked
+     *
+     * @return Vector path
+     * @throws std::runtime_error if no path exists
+     */
+    vector<int> shortest_path(int start, int end)
+    {
+        int meet = search(start, end).second;
+        if (meet == -1) {
+            throw std::runtime_error("No path found");
+        }
+
+        // Arcs in path order
+        vector<int> path_arcs;
+        for (int v = meet; v != start; ) {
+            int a = forward.parent(v);
+            path_arcs.push_back(a);
+            v = arcs[a].from;
+        }
+        reverse(path_arcs.begin(), path_arcs.end());
+
+        for (int v = meet; v != end; ) {
+            int a = backward.parent(v);
+            path_arcs.push_back(a);
+            v = arcs[a].to;
+        }
+
+        vector<int> path = {start};
+        vector<int> stack;
+        for (int a : path_arcs) {
+            stack.push_back(a);
+            while (!stack.empty()) {
+                int b = stack.back();
+                stack.pop_back();
+
+                if (arcs[b].first == -1) {
+                    path.push_back(arcs[b].to);
+                } else {
+                    stack.push_back(arcs[b].second);
+                    stack.push_back(arcs[b].first);
+                }
+            }
+        }
+
+        return path;
+    }
+
+    /**
+     * Save the hierarchy to a binary file
+     * @throws std::runtime_error if the file can not be written
+     */
+    void save(const string & file) const
+    {
+        ofstream out(file, ios::binary);
+        if (!out) {
+            throw std::runtime_error("Could not open " + file);
+        }
+
+        out.write(MAGIC, sizeof(MAGIC));
+        out.write((const char *) &N, sizeof(N));
+        write_vector(out, rank);
+        write_vector(out, arcs);
+        write_vector(out, up_offset);
+        write_vector(out, up);
+        write_vector(out, down_offset);
+        write_vector(out, down);
+
+        if (!out) {
+            throw std::runtime_error("Could not write " + file);
+        }
+    }
+
+    /**
+     * Load a hierarchy written by save()
+     * @throws std::runtime_error if the file is missing or malformed
+     */
+    static ContractionHierarchy load(const string & file)
+    {
+        ifstream in(file, ios::binary);
+        if (!in) {
+            throw std::runtime_error("Could not open " + file);
+        }
+
+        char magic[sizeof(MAGIC)];
+        in.read(magic, sizeof(magic));
+        if (!in || !equal(magic, magic + sizeof(magic), MAGIC)) {
+            throw std::runtime_error("Not a contraction hierarchy: " + file);
+        }
+
+        ContractionHierarchy ch;
+        in.read((char *) &ch.N, sizeof(ch.N));
+        read_vector(in, ch.rank);
+        read_vector(in, ch.arcs);
+        read_vector(in, ch.up_offset);
+        read_vector(in, ch.up);
+        read_vector(in, ch.down_offset);
+        read_vector(in, ch.down);
+
+        if (!in) {
+            throw std::runtime_error("Truncated contraction hierarchy: " + file);
+        }
+
+        if (!ch.valid()) {
+            throw std::runtime_error("Corrupt contraction hierarchy: " + file);
+        }
+
+        return ch;
+    }
+
+private:
+    /**
+     * Check sizes, offsets and indexes of a loaded hierarchy, so
+     * queries and unpacking stay in bounds and terminate
+     */
+    bool valid() const
+    {
+        if (N < 0 || (int) rank.size() != N || (int) up_offset.size() != N + 1 || (int) down_offset.size() != N + 1) {
+            return false;
+        }
+
+        int m = arcs.size();
+        for (int i = 0; i < m; ++i) {
+            auto & a = arcs[i];
+            if (a.from < 0 || a.from >= N || a.to < 0 || a.to >= N) {
+                return false;
+            }
+
+            // Shortcuts only refer to earlier arcs
+            bool original = a.first == -1 && a.second == -1;
+            bool shortcut = 0 <= a.first && a.first < i && 0 <= a.second && a.second < i;
+            if (!original && !shortcut) {
+                return false;
+            }
+        }
+
+        // Arcs of u are list[offset[u] ..], starting (up) or ending (down) at u
+        auto check = [&](const vector<int> & offset, const vector<int> & list, bool is_up) {
+            if (offset[0] != 0 || offset[N] != (int) list.size()) {
+                return false;
+            }
+
+            if (!is_sorted(offset.begin(), offset.end())) {
+                return false;
+            }
+
+            for (int u = 0; u < N; ++u) {
+                for (int i = offset[u]; i < offset[u + 1]; ++i) {
+                    if (list[i] < 0 || list[i] >= m || (is_up ? arcs[list[i]].from : arcs[list[i]].to) != u) {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        };
+
+        return check(up_offset, up, true) && check(down_offset, down, false);
+    }
+
+    static constexpr char MAGIC[8] = {'C', 'H', 'T', 'D', 'D', '9', '5', '1'};
+
+    /**
+     * Query buffers
+     */
+    QueryEngine::SearchSpace forward;
+    QueryEngine::SearchSpace backward;
+
+    /*
+     * Preprocessing state, released after construction
+     */
+    vector<vector<int>> out_arcs;
+    vector<vector<int>> in_arcs;
+    vector<bool> contracted;
+    vector<int> contracted_neighbors;
+    vector<char> is_target;
+    vector<pair<ll, int>> targets;
+    QueryEngine::SearchSpace witness;
+
+    /**
+     * Add arc u -> v, or lower the weight of an
+     * existing one between uncontracted nodes
+     */
+    void add_arc(int u, int v, ll w, int first, int second)
+    {
+        for (int & a : out_arcs[u]) {
+            if (arcs[a].to != v) {
+                continue;
+            }
+
+            if (arcs[a].w <= w) {
+                return;
+            }
+
+            int old = a;
+            a = arcs.size();
+            for (int & b : in_arcs[v]) {
+                if (b == old) {
+                    b = a;
+                }
+            }
+
+            arcs.push_back({u, v, w, first, second});
+            return;
+        }
+
+        out_arcs[u].push_back(arcs.size());
+        in_arcs[v].push_back(arcs.size());
+        arcs.push_back({u, v, w, first, second});
+    }
+
+    /**
+     * Remove arc a from a list (order does not matter)
+     */
+    static void erase_arc(vector<int> & list, int a)
+    {
+        for (int & b : list) {
+            if (b == a) {
+                b = list.back();
+                list.pop_back();
+                return;
+            }
+        }
+    }
+
+    /**
+     * Contract v, or only count the shortcuts it would need
+     *
+     * @param simulate Count only, do not add shortcuts
+     * @return Number of shortcuts
+     */
+    int contract(int v, bool simulate)
+    {
+        int shortcuts = 0;
+
+        for (int a : in_arcs[v]) {
+            int u = arcs[a].from;
+            if (contracted[u]) {
+                continue;
+            }
+
+            targets.clear();
+            for (int b : out_arcs[v]) {
+                int w = arcs[b].to;
+                if (!contracted[w] && w != u) {
+                    targets.push_back({arcs[a].w + arcs[b].w, w});
+                }
+            }
+
+            if (targets.empty()) {
+                continue;
+            }
+
+            witness_search(u, v, simulate ? ESTIMATE_LIMIT : WITNESS_LIMIT);
+
+            for (int b : out_arcs[v]) {
+                int w = arcs[b].to;
+                if (contracted[w] || w == u) {
+                    continue;
+                }
+
+                ll need = arcs[a].w + arcs[b].w;
+                if (witness.get(w) <= need) {
+                    continue;
+                }
+
+                shortcuts++;
+                if (!simulate) {
+                    add_arc(u, w, need, a, b);
+                }
+            }
+        }
+
+        return shortcuts;
+    }
+
+    /**
+     * Bounded Dijkstra from u in the remaining graph, avoiding v.
+     *
+     * The bound is the largest need among targets not settled yet,
+     * so it shrinks as targets settle and the search stops once all
+     * of them are settled.
+     */
+    void witness_search(int u, int v, int limit)
+    {
+        // Largest need first, next is the first unsettled target
+        sort(targets.begin(), targets.end(), greater<pair<ll, int>>());
+        for (auto [need, w] : targets) {
+            is_target[w] = true;
+        }
+
+        witness.reset(N);
+        witness.set(u, 0, -1);
+
+        size_t next = 0;
+        int settled = 0;
+        while (!witness.empty() && witness.top() <= targets[next].first && settled < limit) {
+            auto [d, x] = witness.pop();
+            if (d > witness.get(x)) {
+                continue;
+            }
+            settled++;
+
+            if (is_target[x]) {
+                is_target[x] = false;
+                while (next < targets.size() && !is_target[targets[next].second]) {
+                    next++;
+                }
+                if (next == targets.size()) {
+                    break;
+                }
+            }
+
+            for (int a : out_arcs[x]) {
+                int y = arcs[a].to;
+                if (y == v || contracted[y]) {
+                    continue;
+                }
+
+                // Paths longer than the bound can not be witnesses
+                ll alt = d + arcs[a].w;
+                if (alt <= targets[next].first && alt < witness.get(y)) {
+                    witness.set(y, alt, x);
+                }
+            }
+        }
+
+        for (auto [need, w] : targets) {
+            is_target[w] = false;
+        }
+    }
+
+    /**
+     * Contraction priority, lower is contracted first.
+     * Edge difference weighs double, so nodes whose removal
+     * shrinks the graph go first.
+     */
+    int priority(int v)
+    {
+        int removed = 0;
+        for (int a : in_arcs[v]) {
+            removed += !contracted[arcs[a].from];
+        }
+        for (int a : out_arcs[v]) {
+            removed += !contracted[arcs[a].to];
+        }
+
+        return 2 * (contract(v, true) - removed) + contracted_neighbors[v];
+    }
+
+    /**
+     * Upward bidirectional search
+     * @return {distance, meeting node}
+     */
+    pair<ll, int> search(int start, int end)
+    {
+        forward.reset(N);
+        backward.reset(N);
+        forward.set(start, 0, -1);
+        backward.set(end, 0, -1);
+
+        ll best = DIST_INF;
+        int meet = -1;
+
+        while (min(forward.top(), backward.top()) < best) {
+            bool is_forward = forward.top() <= backward.top();
+            auto & X = is_forward ? forward : backward;
+            auto & Y = is_forward ? backward : forward;
+
+            auto [d, u] = X.pop();
+            if (d > X.get(u)) {
+                continue;
+            }
+
+            if (Y.get(u) != DIST_INF && d + Y.get(u) < best) {
+                best = d + Y.get(u);
+                meet = u;
+            }
+
+            auto & offset = is_forward ? up_offset : down_offset;
+            auto & list = is_forward ? up : down;
+            for (int i = offset[u]; i < offset[u + 1]; ++i) {
+                int a = list[i];
+                int v = is_forward ? arcs[a].to : arcs[a].from;
+                ll alt = d + arcs[a].w;
+
+                // Parent is the arc, for unpacking
+                if (alt < X.get(v)) {
+                    X.set(v, alt, a);
+                }
+            }
+        }
+
+        return {best, meet};
+    }
+
+    /**
+     * Flatten per node lists into CSR
+     */
+    static void to_csr(const vector<vector<int>> & lists, vector<int> & offset, vector<int> & flat)
+    {
+        offset.assign(lists.size() + 1, 0);
+        flat.clear();
+        for (int u = 0; u < lists.size(); ++u) {
+            flat.insert(flat.end(), lists[u].begin(), lists[u].end());
+            offset[u + 1] = flat.size();
+        }
+    }
+
+    template <class T>
+    static void write_vector(ofstream & out, const vector<T> & v)
+    {
+        ll size = v.size();
+        out.write((const char *) &size, sizeof(size));
+        out.write((const char *) v.data(), sizeof(T) * size);
+    }
+
+    template <class T>
+    static void read_vector(ifstream & in, vector<T> & v)
+    {
+        ll size = 0;
+        in.read((char *) &size, sizeof(size));
+        if (!in || size < 0) {
+            in.setstate(ios::failbit);
+            return;
+        }
+
+        // Never allocate more than the rest of the file holds
+        auto here = in.tellg();
+        in.seekg(0, ios::end);
+        ll rest = in.tellg() - here;
+        in.seekg(here);
+        if (size > rest / (ll) sizeof(T)) {
+            in.setstate(ios::failbit);
+            return;
+        }
+
+        v.resize(size);
+        in.read((char *) v.data(), sizeof(T) * size);
+    }
+};
+
+/**
+ * Random graph for the benchmark
+ */
+Graph random_graph(int n, int m, int max_weight, mt19937 & rng)
+{
+    Graph G(n, m);
+    for (int i = 0; i < m; ++i) {
+        G.add_edge(rng() % n, rng() % n, rng() % max_weight + 1);
+    }
+
+    return G;
+}
+
+/**
+ * Grid graph (4-neighbourhood, both directions) for the benchmark
+ */
+Graph grid_graph(int rows, int cols, int max_weight, mt19937 & rng)
+{
+    Graph G(rows * cols, 4 * rows * cols);
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            int u = r * cols + c;
+            if (c + 1 < cols) {
+                G.add_edge(u, u + 1, rng() % max_weight + 1);
+                G.add_edge(u + 1, u, rng() % max_weight + 1);
+            }
+            if (r + 1 < rows) {
+                G.add_edge(u, u + cols, rng() % max_weight + 1);
+                G.add_edge(u + cols, u, rng() % max_weight + 1);
+            }
+        }
+    }
+
+    return G;
+}
+
+/**
+ * Time one engine, returning its distances
+ */
+template <class Run>
+vector<ll> time_engine(const string & name, Run run)
+{
+    auto start = chrono::steady_clock::now();
+    vector<ll> dist = run();
+    auto end = chrono::steady_clock::now();
+
+    cout << "  " << name << ": "
+         << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+    return dist;
+}
+
+/**
+ * Benchmark all queues on generated graphs
+ */
+int bench()
+{
+    mt19937 rng(95);
+
+    vector<pair<string, Graph>> graphs;
+    graphs.push_back({"grid 1000x1000 w <= 10", grid_graph(1000, 1000, 10, rng)});
+    graphs.push_back({"grid 1000x1000 w <= 10000", grid_graph(1000, 1000, 10000, rng)});
+    graphs.push_back({"random n = 1e6 m = 5e6 w <= 100", random_graph(1000000, 5000000, 100, rng)});
+    graphs.push_back({"random n = 1e6 m = 5e6 w <= 1e6", random_graph(1000000, 5000000, 1000000, rng)});
+
+    bool ok = true;
+    for (auto & [name, G] : graphs) {
+        cout << name << "\n";
+
+        CSRGraph csr(G);
+        vector<vector<ll>> results;
+
+        results.push_back(time_engine("adjacency list (reference)", [&]() {
+            Graph copy = G;
+            Dijkstra d(move(copy), 0);
+            d.run();
+
+            vector<ll> dist(G.N);
+            for (int i = 0; i < G.N; ++i) {
+                dist[i] = d.dist[i] == Graph::INF ? DIST_INF : d.dist[i];
+            }
+            return dist;
+        }));
+
+        auto csr_engine = [&]<class Queue>() {
+            CSRDijkstra<Queue> d(csr, 0);
+            d.run();
+            return d.dist;
+        };
+
+        results.push_back(time_engine("binary heap", [&]() { return csr_engine.template operator()<BinaryHeap>(); }));
+        results.push_back(time_engine("4-ary heap", [&]() { return csr_engine.template operator()<QuaternaryHeap>(); }));
+        results.push_back(time_engine("radix heap", [&]() { return csr_engine.template operator()<RadixHeap>(); }));
+        if (csr.max_weight <= 100000) {
+            results.push_back(time_engine("dial", [&]() { return csr_engine.template operator()<DialQueue>(); }));
+        }
+
+        for (auto & r : results) {
+            ok = ok && r == results[0];
+        }
+    }
+
+    // Point-to-point queries against one graph
+    {
+        Graph G = grid_graph(1000, 1000, 100, rng);
+        CSRGraph csr(G);
+        QueryEngine engine(G);
+
+        vector<pair<int, int>> queries;
+        for (int i = 0; i < 50; ++i) {
+            queries.push_back({(int) (rng() % G.N), (int) (rng() % G.N)});
+        }
+
+        cout << "50 point-to-point queries, grid 1000x1000 w <= 100\n";
+
+        vector<ll> full = time_engine("full dijkstra per query", [&]() {
+            vector<ll> answers;
+            for (auto [s, t] : queries) {
+                CSRDijkstra<QuaternaryHeap> d(csr, s);
+                d.run();
+                answers.push_back(d.dist[t]);
+            }
+            return answers;
+        });
+
+        vector<ll> single = time_engine("bidirectional query()", [&]() {
+            vector<ll> answers;
+            for (auto [s, t] : queries) {
+                answers.push_back(engine.query(s, t));
+            }
+            return answers;
+        });
+
+        vector<ll> batched = time_engine("batch()", [&]() {
+            return engine.batch(queries);
+        });
+
+        ok = ok && full == single && full == batched;
+    }
+
+    // Contraction hierarchy, preprocessing once
+    {
+        Graph G = grid_graph(320, 320, 100, rng);
+        CSRGraph csr(G);
+        QueryEngine engine(G);
+
+        vector<pair<int, int>> queries;
+        for (int i = 0; i < 1000; ++i) {
+            queries.push_back({(int) (rng() % G.N), (int) (rng() % G.N)});
+        }
+
+        cout << "1000 point-to-point queries, grid 320x320 w <= 100\n";
+
+        auto start = chrono::steady_clock::now();
+        ContractionHierarchy ch(G);
+        auto end = chrono::steady_clock::now();
+        cout << "  contraction: " << chrono::duration<double, milli>(end - start).count()
+             << " ms, " << ch.arcs.size() << " arcs and shortcuts\n";
+
+        vector<ll> bidirectional = time_engine("bidirectional query()", [&]() {
+            vector<ll> answers;
+            for (auto [s, t] : queries) {
+                answers.push_back(engine.query(s, t));
+            }
+            return answers;
+        });
+
+        vector<ll> hierarchy = time_engine("contraction hierarchy query()", [&]() {
+            vector<ll> answers;
+            for (auto [s, t] : queries) {
+                answers.push_back(ch.query(s, t));
+            }
+            return answers;
+        });
+
+        // Round trip through a file
+        string file = (filesystem::temp_directory_path() / "shortestpath1_bench.ch").string();
+        ch.save(file);
+        ContractionHierarchy loaded = ContractionHierarchy::load(file);
+        filesystem::remove(file);
+
+        vector<ll> reloaded;
+        for (auto [s, t] : queries) {
+            reloaded.push_back(loaded.query(s, t));
+        }
+
+        // Unpacked paths against Dijkstra's, same endpoints and length
+        // (ties may pick a different path of the same length)
+        auto arc_weight = [&](int u, int v) {
+            ll w = DIST_INF;
+            for (int i = csr.offset[u]; i < csr.offset[u + 1]; ++i) {
+                if (csr.arcs[i].v == v) {
+                    w = min(w, (ll) csr.arcs[i].w);
+                }
+            }
+            return w;
+        };
+
+        bool paths = true;
+        for (int i = 0; i < 20; ++i) {
+            auto [s, t] = queries[i];
+            CSRDijkstra<QuaternaryHeap> d(csr, s);
+            d.run();
+
+            vector<int> expected = d.shortest_path(t);
+            vector<int> path = loaded.shortest_path(s, t);
+
+            ll length = 0;
+            for (size_t j = 0; j + 1 < path.size(); ++j) {
+                length = min(DIST_INF, length + arc_weight(path[j], path[j + 1]));
+            }
+
+            paths = paths && path.front() == expected.front() && path.back() == expected.back()
+                && length == d.get_distance(t);
+        }
+        cout << "  save / load and unpacked paths: " << (paths && reloaded == hierarchy ? "match" : "differ") << "\n";
+
+        ok = ok && bidirectional == hierarchy && reloaded == hierarchy && paths;
+    }
+
+    cout << (ok ? "ok" : "MISMATCH") << endl;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char ** argv)
+{
+    cin.sync_with_stdio(false);
+    cin.tie(nullptr);
+
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
 
     int n, m, q, s;
     while (1) {
@@ -254,13 +2000,14 @@ int main()
             G.add_edge(u, v, w);
         }
 
-        Dijkstra dijkstra(move(G), s);
+        CSRGraph csr(G);
+        CSRDijkstra<QuaternaryHeap> dijkstra(csr, s);
         dijkstra.run();
 
         for (int i = 0; i < q; i++) {
             cin >> u;
 
-            if (dijkstra.get_distance(u) == Graph::INF) {
+            if (dijkstra.get_distance(u) == DIST_INF) {
                 cout << "Impossible\n";
             } else {
                 cout << dijkstra.get_distance(u) << "\n";
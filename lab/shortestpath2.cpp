@@ -2,6 +2,11 @@
 #include <vector>
 #include <limits>
 #include <queue>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <chrono>
+#include <random>
 
 /**
  * @author Oskar Arensmeier
@@ -48,6 +53,13 @@
  *
  * - Adjacency list using vectors
  * - Priority queue for the Dijkstra's algorithm
+ *
+ *
+ * neighbors() above allocates a fresh vector per expansion. The solution
+ * below uses TimeDependentDijkstra instead: a flat (CSR) arc array where the
+ * wait is computed inline, 64-bit times, and profile() for earliest arrival
+ * over a whole window of departure times. Run with 'bench' as the first
+ * argument to compare against the original on large random timetables.
  */
 
 using namespace std;
@@ -287,11 +299,342 @@ public:
     }
 };
 
-int main()
+/**
+ * Timetable graph in compressed sparse row form
+ *
+ * Out arcs of u are arcs[offset[u]] .. arcs[offset[u+1] - 1].
+ * Arcs keep their schedule (t0, p) so the wait is computed
+ * inline during the search, no per expansion copies.
+ */
+class TimetableGraph
+{
+public:
+
+    /**
+     * Packed arc
+     */
+    struct Arc
+    {
+        int v;
+        int w;
+        int t0;
+        int p;
+    };
+
+    /**
+     * Node count
+     */
+    int N;
+
+    /**
+     * Arcs of u are [offset[u], offset[u+1])
+     */
+    vector<int> offset;
+
+    /**
+     * All arcs, grouped by source node
+     */
+    vector<Arc> arcs;
+
+    /**
+     * Constructor
+     * @param G Graph to lay out
+     */
+    TimetableGraph(const Graph & G) : N(G.N)
+    {
+        offset.assign(N + 1, 0);
+        for (int u = 0; u < N; ++u) {
+            offset[u + 1] = offset[u] + G.adj[u].size();
+        }
+
+        arcs.reserve(offset[N]);
+        for (int u = 0; u < N; ++u) {
+            for (auto & e : G.adj[u]) {
+                arcs.push_back({e.v, e.w, e.t0, e.p});
+            }
+        }
+    }
+
+    /**
+     * Earliest departure along an arc when standing at its tail at time t
+     *
+     * @return Departure time, -1 if the arc can no longer be taken
+     */
+    static ll departure(const Arc & e, ll t)
+    {
+        // Wait until t0
+        if (t <= e.t0) {
+            return e.t0;
+        }
+
+        // Too late, only departs once
+        if (e.p == 0) {
+            return -1;
+        }
+
+        // Wait until next departure
+        return e.t0 + (t - e.t0 + e.p - 1) / e.p * e.p;
+    }
+};
+
+/**
+ * Infinite 64-bit time
+ */
+const ll TIME_INF = numeric_limits<ll>::max();
+
+/**
+ * Time-dependent Dijkstra over a TimetableGraph
+ *
+ * Same algorithm as Dijkstra above (valid since waiting is allowed, so
+ * leaving later never arrives earlier), with 64-bit times and the wait
+ * computed inline from each arc's schedule.
+ *
+ * profile() answers earliest arrival for every departure time in a
+ * window at once. Arrival at the target only changes at departures of
+ * the start's own arcs (otherwise one waits at the start anyway), so it
+ * runs one search per such departure, latest first. A search stops
+ * expanding a node as soon as it reaches it no earlier than a later
+ * departure did, since everything beyond is then no better either
+ * (self-pruning). Later searches therefore only touch the part of the
+ * graph where leaving earlier actually helps.
+ */
+class TimeDependentDijkstra
+{
+public:
+
+    /**
+     * Graph
+     */
+    const TimetableGraph & G;
+
+    /**
+     * Earliest arrival at each node of the last run()
+     */
+    vector<ll> time;
+
+    /**
+     * Previous node in the path
+     */
+    vector<int> prev;
+
+    /**
+     * Constructor
+     * @param G Graph
+     */
+    TimeDependentDijkstra(const TimetableGraph & G) : G(G) {}
+
+    /**
+     * Earliest arrival at every node
+     *
+     * @param start Start node
+     * @param departure Time of leaving start
+     */
+    void run(int start, ll departure = 0)
+    {
+        time.assign(G.N, TIME_INF);
+        prev.assign(G.N, -1);
+        search(start, departure, time);
+    }
+
+    /**
+     * Get time from start to end of the last run()
+     *
+     * @note Returns TIME_INF if no path exists
+     */
+    ll get_time(int end) const
+    {
+        return time[end];
+    }
+
+    /**
+     * Earliest arrival profile
+     *
+     * @param start Start node
+     * @param end End node
+     * @param lo First departure time
+     * @param hi Last departure time
+     * @return {departure, arrival} pairs, increasing in both. Leaving at
+     *   t in [lo, hi] arrives at the arrival of the first pair with
+     *   departure >= t, or never if there is none. The last pair may
+     *   depart after hi, when waiting past the window pays off.
+     * @throws std::invalid_argument if start == end
+     */
+    vector<pair<ll, ll>> profile(int start, int end, ll lo, ll hi)
+    {
+        if (start == end) {
+            throw std::invalid_argument("Profile from a node to itself");
+        }
+
+        // Departures from start within the window, plus the first one
+        // after it since leaving late in the window may wait for it
+        vector<ll> departures;
+        for (int i = G.offset[start]; i < G.offset[start + 1]; ++i) {
+            auto & e = G.arcs[i];
+            for (ll t = TimetableGraph::departure(e, lo); t != -1; t += e.p) {
+                departures.push_back(t);
+                if (t > hi || e.p == 0) {
+                    break;
+                }
+            }
+        }
+
+        sort(departures.begin(), departures.end());
+        departures.erase(unique(departures.begin(), departures.end()), departures.end());
+
+        // Best arrival over all later departures, shared by all
+        // searches so a node is only expanded when reached earlier
+        vector<ll> best(G.N, TIME_INF);
+        prev.assign(G.N, -1);
+
+        // Only departures arriving strictly earlier than any later one
+        vector<pair<ll, ll>> result;
+        for (int i = departures.size() - 1; i >= 0; --i) {
+            ll before = best[end];
+            search(start, departures[i], best);
+
+            if (best[end] < before) {
+                result.push_back({departures[i], best[end]});
+            }
+        }
+
+        reverse(result.begin(), result.end());
+        return result;
+    }
+
+private:
+    /**
+     * One time-dependent search
+     *
+     * @param start Start node
+     * @param departure Time of leaving start
+     * @param label Arrival times, only lowered. Nodes not reached
+     *   earlier than their current label are not expanded.
+     */
+    void search(int start, ll departure, vector<ll> & label)
+    {
+        label[start] = departure;
+
+        priority_queue<
+            pair<ll, int>,
+            vector<pair<ll, int>>,
+            greater<pair<ll, int>>
+        > pq;
+
+        pq.push({departure, start});
+
+        while (!pq.empty()) {
+            auto [t, u] = pq.top();
+            pq.pop();
+
+            // Skip if we've already seen a shorter path
+            if (t > label[u]) {
+                continue;
+            }
+
+            for (int i = G.offset[u]; i < G.offset[u + 1]; ++i) {
+                auto & e = G.arcs[i];
+
+                ll dep = TimetableGraph::departure(e, t);
+                if (dep == -1) {
+                    continue;
+                }
+
+                ll alt = dep + e.w;
+                if (alt < label[e.v]) {
+                    label[e.v] = alt;
+                    prev[e.v] = u;
+                    pq.push({alt, e.v});
+                }
+            }
+        }
+    }
+};
+
+/**
+ * Random timetable for the benchmark
+ */
+Graph random_timetable(int n, int m, mt19937 & rng)
+{
+    Graph G(n, m);
+    for (int i = 0; i < m; ++i) {
+        int p = rng() % 10 == 0 ? 0 : rng() % 60 + 1;
+        G.add_edge(rng() % n, rng() % n, rng() % 100 + 1, rng() % 1000, p);
+    }
+
+    return G;
+}
+
+/**
+ * Benchmark against the original Dijkstra
+ */
+int bench()
+{
+    mt19937 rng(95);
+    bool ok = true;
+
+    for (auto [n, m] : vector<pair<int, int>>{{100000, 500000}, {1000000, 5000000}}) {
+        Graph G = random_timetable(n, m, rng);
+        cout << "random timetable n = " << n << " m = " << m << "\n";
+
+        auto start = chrono::steady_clock::now();
+        Graph copy = G;
+        Dijkstra reference(move(copy), 0);
+        reference.run();
+        auto end = chrono::steady_clock::now();
+        cout << "  neighbors() per expansion: "
+             << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        start = chrono::steady_clock::now();
+        TimetableGraph T(G);
+        TimeDependentDijkstra engine(T);
+        engine.run(0);
+        end = chrono::steady_clock::now();
+        cout << "  flat arcs, inline wait:    "
+             << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        for (int v = 0; v < n; ++v) {
+            ll expected = reference.get_time(v) == Graph::INF ? TIME_INF : reference.get_time(v);
+            ok = ok && engine.get_time(v) == expected;
+        }
+
+        // Profile over a window vs one search per departure time
+        int target = n - 1;
+        ll lo = 0;
+        ll hi = 200;
+
+        start = chrono::steady_clock::now();
+        auto profile = engine.profile(0, target, lo, hi);
+        end = chrono::steady_clock::now();
+        cout << "  profile [" << lo << ", " << hi << "]:       "
+             << chrono::duration<double, milli>(end - start).count() << " ms, "
+             << profile.size() << " connections\n";
+
+        start = chrono::steady_clock::now();
+        for (ll t = lo; t <= hi; t += 20) {
+            engine.run(0, t);
+
+            auto it = lower_bound(profile.begin(), profile.end(), make_pair(t, (ll) -1));
+            ll expected = it == profile.end() ? TIME_INF : it->second;
+            ok = ok && engine.get_time(target) == expected;
+        }
+        end = chrono::steady_clock::now();
+        cout << "  11 single departures:      "
+             << chrono::duration<double, milli>(end - start).count() << " ms\n";
+    }
+
+    cout << (ok ? "ok" : "MISMATCH") << endl;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char ** argv)
 {
     cin.sync_with_stdio(false);
     cin.tie(nullptr);
 
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
+
     int n, m, q, s;
     while (1) {
         cin >> n >> m >> q >> s;
@@ -307,13 +650,14 @@ int main()
             G.add_edge(u, v, d, t0, p);
         }
 
-        Dijkstra dijkstra(move(G), s);
-        dijkstra.run();
+        TimetableGraph T(G);
+        TimeDependentDijkstra dijkstra(T);
+        dijkstra.run(s);
 
         for (int i = 0; i < q; i++) {
             cin >> u;
 
-            if (dijkstra.get_time(u) == Graph::INF) {
+            if (dijkstra.get_time(u) == TIME_INF) {
                 cout << "Impossible\n";
             } else {
                 cout << dijkstra.get_time(u) << "\n";
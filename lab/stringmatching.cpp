@@ -1,6 +1,17 @@
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <vector>
 #include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <chrono>
+#include <random>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+#include "../util/bench.cpp"
 
 /**
  * @author Oskar Arensmeier
@@ -25,18 +36,27 @@
  * At each point we check if the prefix function value equals the length of the pattern.
  * If it does, we have found an occurrence of the pattern in the text.
  *
+ * Only the prefix function of the pattern is stored, the values for the
+ * text part are consumed as they are produced, so a pattern costs O(m)
+ * memory regardless of the text length.
+ *
  * Time complexity:
  * O(n + m)
  * Where n is the length of text and m is the length of the pattern.
  * 
  * Space complexity:
- * O(n + m)
+ * O(m)
  * 
  * Data structures:
  * - Vector for prefix function
+ *
+ * For many patterns at once see AhoCorasick, for a single pattern over
+ * large texts see FirstLastFilter. Both produce the same position vectors
+ * and can also read the text from a stream, see for_each_block().
  */
 
 using namespace std;
+using ll = long long;
 
 class KnuthMorrisPratt {
 public:
@@ -81,16 +101,20 @@ static vector<int> find_pattern_positions(const string & text, const string & pa
 {
     vector<int> pi = prefix_function(pat);
 
-    // Resize to fit entires for pat + '#' + text
-    pi.resize(pat.size() + text.size() + 1, 0);
-
     int n = pat.size();
     vector<int> res;
-    for (int i = 0; i < text.size(); ++i) {
 
-        // Index in combined string
-        int ii = i + pat.size() + 1;
-        int j = pi[ii-1];
+    // Keep the original output for an empty pattern: every index i + 1
+    if (n == 0) {
+        for (int i = 0; i < (int) text.size(); ++i) {
+            res.push_back(i + 1);
+        }
+        return res;
+    }
+
+    // Prefix function value of pat + '#' + text at the previous index
+    int j = 0;
+    for (int i = 0; i < (int) text.size(); ++i) {
 
         while (j > 0 && pat[j] != text[i]) {
             j = pi[j-1];
@@ -100,11 +124,10 @@ static vector<int> find_pattern_positions(const string & text, const string & pa
             ++j;
         }
 
-        pi[ii] = j;
-
         if (j == n) {
             // Compute start index
             res.push_back(i - n + 1);
+            j = pi[j-1];
         }
     }
 
@@ -112,11 +135,594 @@ static vector<int> find_pattern_positions(const string & text, const string & pa
 }
 };
 
-int main()
+/**
+ * Read a stream in blocks and call fn(data, len, base) on each one, where
+ * base is the stream offset of data[0]. The last keep bytes of a block are
+ * repeated at the start of the next one, so with keep = m - 1 every match
+ * of length m lies inside exactly one block and is reported exactly once.
+ *
+ * @param in Stream to read until end of file
+ * @param keep Number of bytes carried over between blocks
+ * @param fn Callback for each block
+ */
+template <class F>
+void for_each_block(istream & in, size_t keep, F fn)
+{
+    const size_t BLOCK_SIZE = 1 << 20;
+
+    vector<char> buf(keep + BLOCK_SIZE);
+    size_t have = 0;
+    ll base = 0;
+
+    while (true) {
+        in.read(buf.data() + have, BLOCK_SIZE);
+        size_t got = in.gcount();
+        if (got == 0) {
+            break;
+        }
+
+        have += got;
+        fn((const char *) buf.data(), have, base);
+
+        size_t carry = min(keep, have);
+        memmove(buf.data(), buf.data() + have - carry, carry);
+        base += have - carry;
+        have = carry;
+    }
+}
+
+/**
+ * Aho-Corasick automaton, finds all occurrences of a set of patterns
+ * in one pass over the text.
+ *
+ * reference: https://cp-algorithms.com/string/aho_corasick.html
+ *
+ * Algorithm:
+ *
+ * The patterns are inserted into a trie. A breadth-first pass then
+ * computes the suffix link of each state (the longest proper suffix that
+ * is also a trie state) and fills in every missing transition with the
+ * transition of the suffix link, which turns the trie into a complete
+ * automaton. Scanning the text is then one table lookup per byte.
+ *
+ * Bytes that occur in no pattern all behave the same, so bytes are first
+ * mapped to classes (0 for bytes not in any pattern) and the transition
+ * table is a flat array of states x classes. Entries store the target
+ * state pre-multiplied by the number of classes, negated when the target
+ * reports a match, so the hot loop is a load, an add and a sign test.
+ *
+ * A state reports the pattern ending in it, if any, and then follows its
+ * dictionary link: the nearest state on the suffix link chain that ends
+ * a pattern. Identical patterns are chained through same.
+ *
+ * Time complexity:
+ * O(m * k) to build, O(n + z) to scan
+ * Where m is the total pattern length, k the number of distinct bytes in
+ * the patterns, n the length of the text and z the number of matches.
+ *
+ * Space complexity:
+ * O(m * k)
+ *
+ * Data structures:
+ * - Flat vector for the transition table
+ * - Vectors for dictionary links and pattern lists
+ */
+class AhoCorasick {
+public:
+
+/**
+ * Build the automaton
+ *
+ * @param patterns Non-empty patterns, duplicates allowed
+ * @throws invalid_argument if a pattern is empty
+ * @throws length_error if the transition table does not fit in int
+ */
+AhoCorasick(const vector<string> & patterns) : lengths(patterns.size()), same(patterns.size(), -1)
+{
+    classes = 1;
+    fill(begin(byte_class), end(byte_class), 0);
+
+    ll total = 0;
+    for (const string & p : patterns) {
+        if (p.empty()) {
+            throw invalid_argument("patterns must not be empty");
+        }
+
+        total += p.size();
+        for (unsigned char c : p) {
+            if (byte_class[c] == 0) {
+                byte_class[c] = classes++;
+            }
+        }
+    }
+
+    if ((total + 1) * classes > INT32_MAX) {
+        throw length_error("patterns too long for the transition table");
+    }
+
+    // Trie with -1 for missing edges, state ids not yet multiplied
+    delta.assign(classes, -1);
+    first.assign(1, -1);
+
+    for (int k = 0; k < (int) patterns.size(); ++k) {
+        lengths[k] = patterns[k].size();
+
+        int s = 0;
+        for (unsigned char c : patterns[k]) {
+            size_t edge = (size_t) s * classes + byte_class[c];
+            if (delta[edge] == -1) {
+                delta[edge] = first.size();
+                first.push_back(-1);
+                delta.resize(delta.size() + classes, -1);
+            }
+            s = delta[edge];
+        }
+
+        if (first[s] == -1) {
+            first[s] = k;
+        } else {
+            // Keep the chain in pattern order
+            int q = first[s];
+            while (same[q] != -1) {
+                q = same[q];
+            }
+            same[q] = k;
+        }
+    }
+
+    int states = first.size();
+    vector<int> link(states, 0);
+    dict.assign(states, -1);
+
+    vector<int> queue = {0};
+    for (size_t h = 0; h < queue.size(); ++h) {
+        int u = queue[h];
+        int * row = &delta[(size_t) u * classes];
+        const int * link_row = &delta[(size_t) link[u] * classes];
+
+        for (int c = 0; c < classes; ++c) {
+            int v = row[c];
+
+            if (v == -1) {
+                row[c] = u == 0 ? 0 : link_row[c];
+                continue;
+            }
+
+            link[v] = u == 0 ? 0 : link_row[c];
+            dict[v] = first[link[v]] != -1 ? link[v] : dict[link[v]];
+            queue.push_back(v);
+        }
+    }
+
+    // Pre-multiply and mark reporting targets, in place
+    for (int & t : delta) {
+        bool reports = first[t] != -1 || dict[t] != -1;
+        t *= classes;
+        if (reports) {
+            t = -t;
+        }
+    }
+}
+
+/**
+ * Number of patterns
+ */
+int size() const
+{
+    return lengths.size();
+}
+
+/**
+ * Scan a block of text, continuing from a previous block
+ *
+ * @param state State returned by the previous call, 0 to start
+ * @param data Text block
+ * @param len Length of the block
+ * @param base Offset of data[0] in the whole text
+ * @param emit Called as emit(pattern, start) for each match
+ * @return State to pass with the next block
+ */
+template <class Emit>
+int feed(int state, const char * data, size_t len, ll base, Emit && emit) const
+{
+    const unsigned char * text = (const unsigned char *) data;
+    const int * table = delta.data();
+
+    int s = state;
+    for (size_t i = 0; i < len; ++i) {
+        s = table[s + byte_class[text[i]]];
+
+        if (s < 0) {
+            s = -s;
+            report(s / classes, base + (ll) i, emit);
+        }
+    }
+
+    return s;
+}
+
+/**
+ * Scan a stream until end of file
+ *
+ * @param in Stream with the text
+ * @param emit Called as emit(pattern, start) for each match
+ */
+template <class Emit>
+void scan(istream & in, Emit && emit) const
+{
+    int state = 0;
+    for_each_block(in, 0, [&](const char * data, size_t len, ll base) {
+        state = feed(state, data, len, base, emit);
+    });
+}
+
+/**
+ * Find all occurrences of every pattern
+ *
+ * @param text Text
+ * @return For each pattern, the vector of start indexes in increasing order
+ */
+vector<vector<int>> find_all(const string & text) const
+{
+    vector<vector<int>> res(size());
+    feed(0, text.data(), text.size(), 0, [&](int k, ll start) {
+        res[k].push_back(start);
+    });
+
+    return res;
+}
+
+private:
+
+/** Byte to column of the transition table */
+int byte_class[256];
+
+/** Columns of the transition table */
+int classes;
+
+/** Transition table, states x classes, see class comment for encoding */
+vector<int> delta;
+
+/** Lowest numbered pattern ending in each state, -1 if none */
+vector<int> first;
+
+/** Nearest proper suffix state that ends a pattern, -1 if none */
+vector<int> dict;
+
+/** Length of each pattern */
+vector<int> lengths;
+
+/** Next pattern identical to each pattern, -1 if none */
+vector<int> same;
+
+/**
+ * Report all patterns ending in state s at text index end
+ */
+template <class Emit>
+void report(int s, ll end, Emit & emit) const
+{
+    for (; s != -1; s = dict[s]) {
+        for (int k = first[s]; k != -1; k = same[k]) {
+            emit(k, end - lengths[k] + 1);
+        }
+    }
+}
+};
+
+/**
+ * Single pattern search with a first/last byte SIMD prefilter.
+ *
+ * reference: http://0x80.pl/articles/simd-strfind.html
+ *
+ * Algorithm:
+ *
+ * For 32 candidate start positions at a time, compare the bytes at the
+ * candidates with the first byte of the pattern and the bytes m - 1
+ * further with the last byte, using one AVX2 compare each. Only the
+ * positions where both match are verified with memcmp. On real text the
+ * pair of bytes rarely matches by chance, so most of the text is passed
+ * over at a few instructions per 32 bytes.
+ *
+ * Without AVX2 the first byte is found with memchr instead, which libc
+ * vectorizes as well.
+ *
+ * Time complexity:
+ * O(n) expected, O(n * m) worst case (e.g. a^m in a^n)
+ * Where n is the length of text and m is the length of the pattern.
+ *
+ * Space complexity:
+ * O(m)
+ */
+class FirstLastFilter {
+public:
+
+/**
+ * @param pat Non-empty pattern
+ * @throws invalid_argument if the pattern is empty
+ */
+FirstLastFilter(const string & pat) : pat(pat)
+{
+    if (pat.empty()) {
+        throw invalid_argument("pattern must not be empty");
+    }
+}
+
+/**
+ * Scan a block of text. Matches must lie entirely inside the block, see
+ * for_each_block() for carrying the overlap between blocks.
+ *
+ * @param data Text block
+ * @param len Length of the block
+ * @param base Offset of data[0] in the whole text
+ * @param emit Called as emit(start) for each match
+ */
+template <class Emit>
+void feed(const char * data, size_t len, ll base, Emit && emit) const
+{
+    size_t m = pat.size();
+    if (len < m) {
+        return;
+    }
+
+    // Candidates are start positions [0, len - m]
+    size_t i = 0;
+    if (has_avx2()) {
+        i = scan_avx2(data, len - m + 1, base, emit);
+    }
+
+    const char * p = pat.data();
+    while (i + m <= len) {
+        const char * hit = (const char *) memchr(data + i, p[0], len - m + 1 - i);
+        if (hit == nullptr) {
+            break;
+        }
+
+        i = hit - data;
+        if (data[i + m - 1] == p[m - 1] && memcmp(data + i + 1, p + 1, m - 1) == 0) {
+            emit(base + (ll) i);
+        }
+        ++i;
+    }
+}
+
+/**
+ * Scan a stream until end of file
+ *
+ * @param in Stream with the text
+ * @param emit Called as emit(start) for each match
+ */
+template <class Emit>
+void scan(istream & in, Emit && emit) const
+{
+    for_each_block(in, pat.size() - 1, [&](const char * data, size_t len, ll base) {
+        feed(data, len, base, emit);
+    });
+}
+
+/**
+ * Find all occurrences of the pattern, same result as
+ * KnuthMorrisPratt::find_pattern_positions()
+ *
+ * @param text Text
+ * @return Vector of indexes
+ */
+vector<int> find(const string & text) const
+{
+    vector<int> res;
+    feed(text.data(), text.size(), 0, [&](ll start) {
+        res.push_back(start);
+    });
+
+    return res;
+}
+
+private:
+
+/** Pattern */
+string pat;
+
+static bool has_avx2()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Check candidates [0, count) in blocks of 32
+ *
+ * @return First candidate not checked
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+template <class Emit>
+__attribute__((target("avx2")))
+size_t scan_avx2(const char * data, size_t count, ll base, Emit & emit) const
+{
+    size_t m = pat.size();
+    const __m256i first = _mm256_set1_epi8(pat[0]);
+    const __m256i last = _mm256_set1_epi8(pat[m - 1]);
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i head = _mm256_loadu_si256((const __m256i *) (data + i));
+        __m256i tail = _mm256_loadu_si256((const __m256i *) (data + i + m - 1));
+        __m256i both = _mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last));
+
+        uint32_t mask = _mm256_movemask_epi8(both);
+        while (mask != 0) {
+            size_t j = i + __builtin_ctz(mask);
+            if (m <= 2 || memcmp(data + j + 1, pat.data() + 1, m - 2) == 0) {
+                emit(base + (ll) j);
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    return i;
+}
+#else
+template <class Emit>
+size_t scan_avx2(const char *, size_t, ll, Emit &) const
+{
+    return 0;
+}
+#endif
+};
+
+/**
+ * Compare KMP per pattern, Aho-Corasick and the SIMD prefilter on
+ * log-like text, checking that they agree
+ */
+int bench()
+{
+    mt19937 rng(1);
+    bool ok = true;
+
+    const vector<string> words = {
+        "INFO", "WARN", "ERROR", "DEBUG", "request", "user", "session", "timeout",
+        "connection", "closed", "opened", "GET", "POST", "/api/v1/items", "/login",
+        "status=200", "status=404", "status=500", "latency_ms=", "retry", "cache", "miss"
+    };
+
+    auto make_log = [&](size_t n) {
+        string text;
+        text.reserve(n + 64);
+        while (text.size() < n) {
+            text += to_string(1700000000 + rng() % 100000000);
+            for (int w = rng() % 6 + 3; w > 0; --w) {
+                text += ' ';
+                text += words[rng() % words.size()];
+                if (rng() % 3 == 0) {
+                    text += to_string(rng() % 100000);
+                }
+            }
+            text += '\n';
+        }
+        text.resize(n);
+        return text;
+    };
+
+    // Empty pattern, same positions as the original implementation
+    {
+        vector<int> expected = {1, 2, 3};
+        ok = ok && KnuthMorrisPratt::find_pattern_positions("abc", "") == expected;
+        ok = ok && KnuthMorrisPratt::find_pattern_positions("", "").empty();
+    }
+
+    // Many patterns, half taken from the text, half random
+    {
+        string text = make_log(16 << 20);
+        vector<string> patterns;
+        for (int k = 0; k < 200; ++k) {
+            int len = rng() % 20 + 4;
+            if (k % 2 == 0) {
+                patterns.push_back(text.substr(rng() % (text.size() - len), len));
+            } else {
+                string p;
+                for (int c = 0; c < len; ++c) {
+                    p += "abcdefghijklmnopqrstuvwxyz0123456789 =/"[rng() % 39];
+                }
+                patterns.push_back(p);
+            }
+        }
+
+        cout << "200 patterns, 16 MiB\n";
+
+        vector<vector<int>> kmp(patterns.size());
+        double t = Bench::time([&] {
+            for (size_t k = 0; k < patterns.size(); ++k) {
+                kmp[k] = KnuthMorrisPratt::find_pattern_positions(text, patterns[k]);
+            }
+        });
+        cout << "  kmp per pattern: " << t << " ms\n";
+
+        AhoCorasick ac(patterns);
+        vector<vector<int>> res;
+        t = Bench::time([&] { res = ac.find_all(text); });
+        cout << "  aho-corasick: " << t << " ms\n";
+        ok = ok && res == kmp;
+
+        istringstream in(text);
+        vector<vector<int>> streamed(patterns.size());
+        t = Bench::time([&] { ac.scan(in, [&](int k, ll start) { streamed[k].push_back(start); }); });
+        cout << "  aho-corasick (stream): " << t << " ms\n";
+        ok = ok && streamed == kmp;
+    }
+
+    // One pattern over a larger text
+    {
+        string text = make_log(256 << 20);
+        string pat = "status=500 retry";
+
+        cout << "1 pattern, 256 MiB\n";
+
+        vector<int> kmp;
+        double t = Bench::time([&] { kmp = KnuthMorrisPratt::find_pattern_positions(text, pat); });
+        cout << "  kmp: " << t << " ms\n";
+
+        FirstLastFilter filter(pat);
+        vector<int> res;
+        t = Bench::time([&] { res = filter.find(text); });
+        cout << "  first/last filter: " << t << " ms\n";
+        ok = ok && res == kmp;
+
+        istringstream in(text);
+        vector<int> streamed;
+        t = Bench::time([&] { filter.scan(in, [&](ll start) { streamed.push_back(start); }); });
+        cout << "  first/last filter (stream): " << t << " ms\n";
+        ok = ok && streamed == kmp;
+
+        cout << "  matches: " << kmp.size() << "\n";
+    }
+
+    return Bench::report(ok);
+}
+
+/**
+ * Print "pattern start" for every match of the patterns in the file
+ * (one per line) in the text read from stdin
+ */
+int scan_patterns(const char * path)
+{
+    ifstream file(path);
+    if (!file) {
+        cerr << "Cannot open " << path << endl;
+        return 1;
+    }
+
+    vector<string> patterns;
+    string line;
+    while (getline(file, line)) {
+        if (!line.empty()) {
+            patterns.push_back(line);
+        }
+    }
+
+    AhoCorasick ac(patterns);
+    ac.scan(cin, [](int k, ll start) {
+        cout << k << ' ' << start << '\n';
+    });
+
+    cout << flush;
+    return 0;
+}
+
+int main(int argc, char ** argv)
 {
     cin.tie(nullptr);
     cin.sync_with_stdio(false);
 
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
+
+    if (argc > 2 && string(argv[1]) == "scan") {
+        return scan_patterns(argv[2]);
+    }
+
     string pat;
     string text;
 
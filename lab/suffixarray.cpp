@@ -1,6 +1,9 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <chrono>
+#include <random>
+#include "../util/suffixarray.cpp"
 
 /**
  * @author Oskar Arensmeier
@@ -12,15 +15,12 @@
  * Reference: https://cp-algorithms.com/string/suffix-array.html
  *
  * Algorithm:
- * 0. Append unique char as end marker: 0x1
- * 1. Sort cyclic shifts using counting sort
- * 2. Create equivalence classes based on first char
- * 3. For each h, sort cyclic shifts of length 2^h
- * 4. Use prev equivalence classes to sort current cyclic shifts
- * 5. Repeat until 2^h >= n
+ * Construction is SA-IS (induced sorting) from util/suffixarray.cpp.
+ * The prefix doubling sort this class used before lives there too,
+ * as prefix_doubling(), and is compared against in bench().
  * 
  * Time complexity:
- * O(n log n)
+ * O(n)
  * where n is the length of the string
  * 
  * Space complexity:
@@ -34,8 +34,6 @@ using namespace std;
 
 class SuffixArray {
 
-static const int ALPHABET_SIZE = 256; // ASCII size
-
 public:
 
 /**
@@ -48,14 +46,9 @@ vector<int> suffix;
  *
  * @param str String
  */
-SuffixArray(const string & str)
+SuffixArray(const string & str) : str(str)
 {
-    // Append unique char
-    this->str = str + (char) 0x1;
-    this->suffix = sort_cyclic_shifts(this->str);
-
-    // Remove '0x1'
-    this->suffix.erase(this->suffix.begin());
+    this->suffix = SAIS::suffix_array<int>(this->str);
 }
 
 /**
@@ -78,94 +71,6 @@ private:
  * String
  */
 string str;
-
-/**
- * Sort cyclic shifts of the string
- *
- * @param s String
- * @return Sorted suffixes
- */
-vector<int> sort_cyclic_shifts(string const& s) {
-    int n = s.size();
-    vector<int> perm(n);                       // Permutation of indices
-    vector<int> cls(n);                        // Equivalence classes
-    vector<int> cnt(max(ALPHABET_SIZE, n), 0); // Count of chars - for count sort
-
-    /* 
-    Inital phase sorts based on single char,
-    and creates first equivalence classes.
-    */
-
-    for (int i = 0; i < n; i++) {
-        cnt[s[i]]++;
-    }
-    for (int i = 1; i < ALPHABET_SIZE; i++) {
-        cnt[i] += cnt[i-1];
-    }
-    for (int i = 0; i < n; i++) {
-        perm[--cnt[s[i]]] = i;
-    }
-
-    cls[perm[0]] = 0;
-    int cls_count = 1;
-    for (int i = 1; i < n; i++) {
-        if (s[perm[i]] != s[perm[i-1]]) {
-            cls_count++;
-        }
-
-        cls[perm[i]] = cls_count - 1;
-    }
-
-    vector<int> perm_tmp(n);
-    vector<int> cls_tmp(n);
-
-    /* 
-    Second phase continuously increases the length of the cyclic shifts
-    being sorted, doubling the length each iteration.
-    */
-
-    for (int h = 0; (1 << h) < n; ++h) {
-
-        for (int i = 0; i < n; i++) {
-            perm_tmp[i] = perm[i] - (1 << h);
-
-            if (perm_tmp[i] < 0) {
-                perm_tmp[i] += n;
-            }
-        }
-
-        fill(cnt.begin(), cnt.begin() + cls_count, 0);
-
-        for (int i = 0; i < n; i++) {
-            cnt[cls[perm_tmp[i]]]++;
-        }
-        for (int i = 1; i < cls_count; i++) {
-            cnt[i] += cnt[i-1];
-        }
-        for (int i = n-1; i >= 0; i--) {
-            perm[--cnt[cls[perm_tmp[i]]]] = perm_tmp[i];
-        }
-
-        // Radix like idea using the previous equivalence classes
-        cls_tmp[perm[0]] = 0;
-        cls_count = 1;
-        for (int i = 1; i < n; i++) {
-
-            pair<int, int> cur  = {cls[perm[i]],   cls[(perm[i]   + (1 << h)) % n]};
-            pair<int, int> prev = {cls[perm[i-1]], cls[(perm[i-1] + (1 << h)) % n]};
-
-            if (cur != prev) {
-                ++cls_count;
-            }
-
-            cls_tmp[perm[i]] = cls_count - 1;
-        }
-
-        cls.swap(cls_tmp);
-    }
-
-    return perm;
-}
 };
 
 // Split string across a delimiter
@@ -189,11 +94,67 @@ vector<string> split_str(const string & s, char delim)
     return tokens;
 }
 
-int main()
+/**
+ * Compare SA-IS and prefix doubling on genome-like text: random
+ * ACGT with copied stretches, so there are long repeats
+ */
+int bench()
+{
+    mt19937 rng(1);
+    bool ok = true;
+
+    for (int n : {1000000, 10000000, 50000000}) {
+        string text;
+        text.reserve(n);
+        while ((int) text.size() < n) {
+            if (text.size() > 1000 && rng() % 4 == 0) {
+                size_t from = rng() % (text.size() - 1000);
+                text.append(text, from, min<size_t>(rng() % 1000 + 1, n - text.size()));
+            } else {
+                text += "ACGT"[rng() % 4];
+            }
+        }
+
+        cout << "n = " << n << "\n";
+
+        auto start = chrono::steady_clock::now();
+        vector<int32_t> sais = SAIS::suffix_array<int32_t>(text);
+        auto end = chrono::steady_clock::now();
+        cout << "  sa-is (32-bit): " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        start = chrono::steady_clock::now();
+        vector<int64_t> wide = SAIS::suffix_array<int64_t>(text);
+        end = chrono::steady_clock::now();
+        cout << "  sa-is (64-bit): " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        ok = ok && equal(sais.begin(), sais.end(), wide.begin(), wide.end());
+
+        // Doubling needs minutes beyond this
+        if (n > 10000000) {
+            continue;
+        }
+
+        start = chrono::steady_clock::now();
+        vector<int32_t> doubling = SAIS::prefix_doubling<int32_t>(text);
+        end = chrono::steady_clock::now();
+        cout << "  prefix doubling: " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+
+        ok = ok && sais == doubling;
+    }
+
+    cout << (ok ? "ok" : "MISMATCH") << endl;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char ** argv)
 {
     cin.tie(nullptr);
     cin.sync_with_stdio(false);
 
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
+
     string str;
     string queries_line;
 
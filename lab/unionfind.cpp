@@ -1,5 +1,11 @@
 #include <iostream>
 #include <algorithm>
+#include <vector>
+#include <chrono>
+#include <random>
+
+#include "../util/unionfind.cpp"
+#include "../util/bench.cpp"
 
 /**
  * @author Oskar Arensmeier
@@ -19,94 +25,86 @@
  * The data itself can be stored using a simple array. Where each index corresponds
  * to an element, and the value at an index is the parent of that element. (On top of this,
  * we also store a rank array for union optimization.)
+ *
+ * Instead of full path compression, find() does path splitting: every
+ * element on the path is pointed to its grandparent. This keeps the same
+ * amortized bound, needs a single pass and no recursion, so long chains
+ * cannot overflow the stack.
+ *
+ * The class is DSU::UnionFind in util/unionfind.cpp, shared with
+ * lab/minspantree.cpp. For many threads joining concurrently, and for
+ * computing connected components of large edge lists in parallel, see
+ * DSU::ConcurrentUnionFind and DSU::connected_components() next to it,
+ * which bench() compares against the sequential version.
  */
 
 using namespace std;
+using ll = long long;
 
-class UnionFind {
-private:
-    int *parent;
-    int *rank;
-    int size;
-
-public:
-    UnionFind(int n)
-    {
-        size   = n;
-        parent = new int[n];
-        rank   = new int[n];
-
-        for (int i = 0; i < n; i++) {
-            parent[i] = i;
-            rank[i] = 0;
-        }
-    }
+/**
+ * Components of a random graph with DSU::UnionFind and with the parallel
+ * ingestion driver, checking that they agree
+ */
+int bench()
+{
+    mt19937 rng(1);
+    bool ok = true;
 
-    ~UnionFind()
-    {
-        delete[] parent;
-        delete[] rank;
-    }
+    int threads = thread::hardware_concurrency();
 
-    /**
-     * Find set representative for element x
-     * @param x element
-     * @return set representative
-     */
-    int find(int x)
-    {
-        if (parent[x] != x) {
-            return parent[x] = find(parent[x]);
+    for (auto [n, m] : {pair<int, ll>{1000000, 1000000}, {10000000, 10000000}, {10000000, 50000000}}) {
+        vector<pair<uint32_t, uint32_t>> edges(m);
+        for (auto & [u, v] : edges) {
+            u = rng() % n;
+            v = rng() % n;
         }
 
-        return parent[x];
-    }
-
-    /**
-     * Join (union) two sets
-     * @param x first set
-     * @param y second set
-     */
-    void join(int x, int y)
-    {
-        int rx = find(x);
-        int ry = find(y);
-
-        if (rx == ry) {
-            return;
+        cout << "n = " << n << ", m = " << m << "\n";
+
+        ll count = 0;
+        double t = Bench::time([&] {
+            DSU::UnionFind uf(n);
+            for (auto [u, v] : edges) {
+                uf.join(u, v);
+            }
+            for (int i = 0; i < n; ++i) {
+                count += uf.find(i) == i;
+            }
+        });
+        cout << "  sequential: " << t << " ms\n";
+
+        vector<int> thread_counts = {1};
+        if (threads > 1) {
+            thread_counts.push_back(threads);
         }
 
-        if (rank[rx] < rank[ry]) {
-            swap(rx, ry);
+        DSU::Components comp;
+        for (int k : thread_counts) {
+            t = Bench::time([&] { comp = DSU::connected_components(n, edges, k); });
+            cout << "  concurrent, " << k << " threads: " << t << " ms\n";
+            ok = ok && comp.count == count;
         }
 
-        parent[ry] = rx;
-
-        if (rank[rx] == rank[ry]) {
-            rank[rx]++;
-        }
+        cout << "  components: " << comp.count << ", largest: "
+             << *max_element(comp.size.begin(), comp.size.end()) << "\n";
     }
 
-    /**
-     * Check if two sets are the same
-     * @param x first set
-     * @param y second set
-     */
-    bool same(int x, int y)
-    {
-        return find(x) == find(y);
-    }
-};
+    return Bench::report(ok);
+}
 
-int main()
+int main(int argc, char ** argv)
 {
     cin.sync_with_stdio(false);
     cin.tie(nullptr);
 
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return bench();
+    }
+
     int N, M;
     cin >> N >> M;
 
-    UnionFind uf(N);
+    DSU::UnionFind uf(N);
 
     char op;
     int x, y;
@@ -37,6 +37,7 @@ usage() {
     echo "run - run"
     echo "comprun - compile and run"
     echo "complocal - compile using clang++"
+    echo "bench - run benchmark (if supported)"
 }
 
 # Compile and run
@@ -133,6 +134,9 @@ case $2 in
     complocal)
         comp_local $code_path $file_name
     ;;
+    bench)
+        $code_path/sol bench
+    ;;
     *)
         echo "Unknown sub command"
         exit 1
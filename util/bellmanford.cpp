@@ -2,6 +2,10 @@
 #include <vector>
 #include <limits>
 #include <queue>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <barrier>
 
 namespace BellmanFord {
 
@@ -87,6 +91,45 @@ public:
     }
 };
 
+/**
+ * Edge in the flat edge list
+ */
+class FlatEdge
+{
+public:
+
+    /**
+     * From node
+     */
+    int u;
+
+    /**
+     * To node
+     */
+    int v;
+
+    /**
+     * Weight
+     */
+    int w;
+};
+
+/**
+ * Bellman-Ford shortest paths with negative cycle detection
+ *
+ * Three ways to run it, all leaving the same dist:
+ * - run(): relaxation passes over a flat edge list (sorted by source),
+ *   stopping early as soon as a pass changes nothing.
+ * - run_spfa(): queue based (SPFA), only nodes whose distance changed are
+ *   relaxed again. A node whose shortest path reaches n edges lies behind
+ *   a negative cycle.
+ * - run_parallel(): Jacobi style passes, every node takes the min over its
+ *   incoming edges using the previous pass' distances. Nodes are split
+ *   into ranges of roughly equal in-degree, one per thread, so no two
+ *   threads write the same entry.
+ *
+ * In all modes nodes reachable from a negative cycle get distance -INF.
+ */
 class BellmanFord
 {
 public:
@@ -115,10 +158,22 @@ public:
      */
     vector<int> negative_cycle;
 
+    /**
+     * All edges, grouped by source node
+     */
+    vector<FlatEdge> edges;
+
     BellmanFord(Graph && G, int start) : G(move(G)), start(start)
     {
         dist.resize(this->G.N, INF);
         prev.resize(this->G.N, -1);
+
+        edges.reserve(this->G.M);
+        for (int u = 0; u < this->G.N; ++u) {
+            for (auto & e : this->G.adj[u]) {
+                edges.push_back({u, e.v, e.w});
+            }
+        }
     }
 
     /**
@@ -128,74 +183,230 @@ public:
     {
         dist[start] = 0;
 
-        // Time complexity O(n * m)
-        for (int i = 0; i < G.N-1; ++i) {
+        // Time complexity O(n * m), stops early
+        // once a full pass makes no update
+        bool changed = true;
+        for (int i = 0; i < G.N-1 && changed; ++i) {
+            changed = false;
 
-            // These two loops involve m steps
-            for (int u = 0; u < G.N; ++u) {
-                for (auto e : G.neighbors(u)) {
+            for (auto & e : edges) {
 
-                    // Not reached
-                    if (dist[u] >= INF) {
-                        continue;
-                    }
-
-                    ll alt = dist[u] + e.w;
-                    // No improvement
-                    if (alt >= dist[e.v]) {
-                        continue;
-                    }
+                // Not reached
+                if (dist[e.u] >= INF) {
+                    continue;
+                }
 
-                    dist[e.v] = max(-INF, alt);
-                    prev[e.v] = u;
+                ll alt = dist[e.u] + e.w;
+                // No improvement
+                if (alt >= dist[e.v]) {
+                    continue;
                 }
+
+                dist[e.v] = max(-INF, alt);
+                prev[e.v] = e.u;
+                changed = true;
             }
         }
 
+        // Converged, no negative cycle
+        if (!changed) {
+            return;
+        }
+
         // Check for negative cycles
         // If any node is updated, there exists a negative cycle
-        bool changed = false;
         vector<int> neg;
-        for (int u = 0; u < G.N; ++u) {
-            for (auto e : G.neighbors(u)) {
+        for (auto & e : edges) {
 
-                // Not reached
-                if (dist[u] >= INF) {
-                    continue;
-                }
+            // Not reached
+            if (dist[e.u] >= INF) {
+                continue;
+            }
+
+            ll alt = dist[e.u] + e.w;
+            // No improvement
+            if (alt >= dist[e.v]) {
+                continue;
+            }
+
+            dist[e.v] = max(-INF, alt);
+            prev[e.v] = e.u;
+            neg.push_back(e.v);
+        }
 
+        mark_negative(neg);
+    }
+
+    /**
+     * Run queue based Bellman-Ford (SPFA)
+     *
+     * Time complexity O(n * m) worst case, usually close to O(m)
+     */
+    void run_spfa()
+    {
+        int n = G.N;
+        dist[start] = 0;
+
+        // Edges on current shortest path
+        vector<int> length(n, 0);
+        vector<bool> queued(n, false);
+
+        queue<int> q;
+        q.push(start);
+        queued[start] = true;
+
+        while (!q.empty()) {
+            int u = q.front();
+            q.pop();
+            queued[u] = false;
+
+            // Marked while queued
+            if (dist[u] == -INF) {
+                continue;
+            }
+
+            for (auto & e : G.adj[u]) {
                 ll alt = dist[u] + e.w;
-                // No improvement
-                if (alt >= dist[e.v]) {
+                if (dist[e.v] == -INF || alt >= dist[e.v]) {
                     continue;
                 }
 
-                dist[e.v] = max(-INF, alt);
+                dist[e.v] = alt;
                 prev[e.v] = u;
-                changed = true;
-                neg.push_back(e.v);
+                length[e.v] = length[u] + 1;
+
+                // Path with n edges repeats a node, following prev
+                // n times lands on the (negative) cycle itself
+                if (length[e.v] >= n) {
+                    int c = e.v;
+                    for (int i = 0; i < n && c != -1; ++i) {
+                        c = prev[c];
+                    }
+
+                    mark_negative(c == -1 ? vector<int>{e.v} : vector<int>{c, e.v});
+                    continue;
+                }
+
+                if (!queued[e.v]) {
+                    q.push(e.v);
+                    queued[e.v] = true;
+                }
             }
         }
+    }
 
-        if (!changed) {
-            return;
+    /**
+     * Run Jacobi style Bellman-Ford across threads
+     *
+     * @param threads Number of threads
+     */
+    void run_parallel(int threads = thread::hardware_concurrency())
+    {
+        int n = G.N;
+        threads = max(1, threads);
+
+        // Incoming edges grouped by target node
+        vector<int> offset(n + 1, 0);
+        for (auto & e : edges) {
+            offset[e.v + 1]++;
+        }
+        for (int v = 0; v < n; ++v) {
+            offset[v + 1] += offset[v];
         }
 
-        // Mark nodes reachable from the negative cycle
-        // BFS
-        while (!neg.empty()) {
-            int u = neg.back();
-            neg.pop_back();
-            dist[u] = -INF;
+        vector<FlatEdge> in(edges.size());
+        vector<int> pos(offset.begin(), offset.end() - 1);
+        for (auto & e : edges) {
+            in[pos[e.v]++] = e;
+        }
 
-            for (auto e : G.neighbors(u)) {
-                if (dist[e.v] == -INF) {
-                    continue;
+        // Node ranges with roughly equal incoming edges
+        vector<int> bounds = {0};
+        for (int t = 1; t < threads; ++t) {
+            ll target = (ll) in.size() * t / threads;
+            int v = lower_bound(offset.begin(), offset.end(), target) - offset.begin();
+            bounds.push_back(max(bounds.back(), min(v, n)));
+        }
+        bounds.push_back(n);
+
+        dist[start] = 0;
+        vector<ll> next = dist;
+        vector<char> changed(threads);
+
+        // One pass over the node range of thread t
+        auto relax = [&](int t) {
+            changed[t] = false;
+            for (int v = bounds[t]; v < bounds[t + 1]; ++v) {
+                ll best = dist[v];
+                for (int i = offset[v]; i < offset[v + 1]; ++i) {
+                    auto & e = in[i];
+                    if (dist[e.u] >= INF || dist[e.u] + e.w >= best) {
+                        continue;
+                    }
+
+                    best = max(-INF, dist[e.u] + e.w);
+                    prev[v] = e.u;
                 }
 
-                neg.push_back(e.v);
+                next[v] = best;
+                changed[t] |= best != dist[v];
+            }
+        };
+
+        // Runs once all ranges are done: up to n - 1 passes
+        // while anything changes, then pass n collects the
+        // nodes still improving
+        int passes = 0;
+        bool done = false;
+        vector<int> neg;
+
+        auto finish = [&]() noexcept {
+            bool any = false;
+            for (int t = 0; t < threads; ++t) {
+                any |= changed[t];
+            }
+
+            bool last = passes == n - 1;
+            if (last && any) {
+                for (int v = 0; v < n; ++v) {
+                    if (next[v] < dist[v]) {
+                        neg.push_back(v);
+                    }
+                }
+            }
+
+            swap(dist, next);
+            ++passes;
+            done = !any || last;
+        };
+
+        if (threads == 1) {
+            while (!done) {
+                relax(0);
+                finish();
+            }
+        } else {
+            barrier sync(threads, finish);
+
+            auto worker = [&](int t) {
+                while (!done) {
+                    relax(t);
+                    sync.arrive_and_wait();
+                }
+            };
+
+            vector<thread> pool;
+            for (int t = 1; t < threads; ++t) {
+                pool.emplace_back(worker, t);
+            }
+            worker(0);
+
+            for (auto & th : pool) {
+                th.join();
             }
         }
+
+        mark_negative(neg);
     }
 
     /**
@@ -222,6 +433,33 @@ public:
         return path;
     }
 
+    /**
+     * Mark nodes reachable from the given nodes with -INF
+     *
+     * @param neg Nodes on or behind a negative cycle
+     */
+    void mark_negative(vector<int> neg)
+    {
+        for (int u : neg) {
+            dist[u] = -INF;
+        }
+
+        // DFS
+        while (!neg.empty()) {
+            int u = neg.back();
+            neg.pop_back();
+
+            for (auto & e : G.adj[u]) {
+                if (dist[e.v] == -INF) {
+                    continue;
+                }
+
+                dist[e.v] = -INF;
+                neg.push_back(e.v);
+            }
+        }
+    }
+
     /**
      * Get distance from start to end
      *
@@ -0,0 +1,37 @@
+/**
+ * @author: Oskar Arensmeier
+ * @date: 2025-05-16
+ */
+
+#pragma once
+
+#include <iostream>
+#include <chrono>
+
+namespace Bench {
+
+using namespace std;
+
+/**
+ * Wall time of f() in milliseconds
+ */
+template <class F>
+double time(F && f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+/**
+ * Print the outcome of a bench's cross checks
+ * @return Exit code for main
+ */
+inline int report(bool ok)
+{
+    cout << (ok ? "ok" : "MISMATCH") << endl;
+    return ok ? 0 : 1;
+}
+
+}
@@ -3,33 +3,554 @@
  * @date: 2025-01-30
  */
 
+#pragma once
+
 #include <vector>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <utility>
 
-class FenwickTree
-{
+/**
+ * Fenwick trees and a lazy segment tree.
+ *
+ * All structures are 0-indexed, and prefix queries take the number of
+ * elements: sum(i) combines a[0] .. a[i - 1], so sum(0) is the identity.
+ *
+ * - FenwickTree: point update, prefix query for any associative and
+ *   commutative Op. Range queries and lower_bound additionally need an
+ *   inverse and monotone prefixes respectively, as for sums of
+ *   non-negative values.
+ * - RangeFenwick: range add and range sum with two Fenwick trees.
+ * - Fenwick2D: point update, rectangle sum.
+ * - LazySegmentTree: range update, range query for operations that have
+ *   no inverse (min, max, assignment), described by a policy type such
+ *   as AddMin, AddMax, AddSum and AssignSum below.
+ */
 
+/**
+ * Fenwick tree over Op.
+ * Reference: https://cp-algorithms.com/data_structures/fenwick.html
+ *
+ * tree[i] (1-indexed) holds the combination of a[i - lowbit(i), i), so
+ * a prefix is the combination of O(log n) nodes found by clearing the
+ * lowest set bit, and an update touches the O(log n) nodes found by
+ * adding it.
+ *
+ * Time complexity:
+ * - Build from an array: O(n)
+ * - add, sum, lower_bound: O(log n)
+ *
+ * Space complexity: O(n)
+ */
+template <class T, class Op = std::plus<T>, class Inv = std::minus<T>>
+class FenwickTree {
 public:
 
+    /**
+     * n elements, all equal to identity
+     *
+     * @param identity Neutral element of Op
+     */
+    FenwickTree(int n, T identity = T(), Op op = Op(), Inv inv = Inv())
+        : n(n), tree(n + 1, identity), identity(identity), op(op), inv(inv) {}
+
+    /**
+     * Build from an array in O(n): every node passes its value on to
+     * its parent once
+     */
+    FenwickTree(const std::vector<T> & a, T identity = T(), Op op = Op(), Inv inv = Inv())
+        : n(a.size()), tree(a.size() + 1, identity), identity(identity), op(op), inv(inv)
+    {
+        for (int i = 1; i <= n; ++i) {
+            tree[i] = op(tree[i], a[i - 1]);
+
+            int parent = i + (i & -i);
+            if (parent <= n) {
+                tree[parent] = op(tree[parent], tree[i]);
+            }
+        }
+    }
+
+    /**
+     * Number of elements
+     */
+    int size() const
+    {
+        return n;
+    }
+
+    /**
+     * a[i] = op(a[i], val)
+     */
+    void add(int i, T val)
+    {
+        for (++i; i <= n; i += i & -i) {
+            tree[i] = op(tree[i], val);
+        }
+    }
+
+    /**
+     * Combination of the first i elements
+     */
+    T sum(int i) const
+    {
+        T res = identity;
+        for (; i > 0; i -= i & -i) {
+            res = op(res, tree[i]);
+        }
+
+        return res;
+    }
+
+    /**
+     * Combination of a[l, r), needs Inv
+     */
+    T sum(int l, int r) const
+    {
+        return inv(sum(r), sum(l));
+    }
+
+    /**
+     * Smallest i such that !comp(sum(i + 1), target), or n if there is
+     * none, assuming sum() is non-decreasing in i under comp. For sums
+     * of non-negative values this is the index of the target-th unit.
+     *
+     * Binary lifting: descend from the highest power of two, taking a
+     * step whenever the prefix it covers is still below target.
+     */
+    template <class Compare = std::less<T>>
+    int lower_bound(T target, Compare comp = Compare()) const
+    {
+        int pos = 0;
+        T acc = identity;
+
+        for (int step = highest_bit(n); step > 0; step >>= 1) {
+            if (pos + step <= n) {
+                T next = op(acc, tree[pos + step]);
+                if (comp(next, target)) {
+                    pos += step;
+                    acc = next;
+                }
+            }
+        }
+
+        return pos;
+    }
+
+private:
+
     int n;
-    std::vector<int> arr;
 
-    FenwickTree(int n): n(n), arr(n+1, 0) {}
+    /** 1-indexed tree, tree[0] unused */
+    std::vector<T> tree;
+
+    T identity;
+    Op op;
+    Inv inv;
 
-    void update(int i, int val)
+    static int highest_bit(int x)
     {
-        for (; i <= this->n; i += i & (-i)) {
-            this->arr[i] += val;
+        return x == 0 ? 0 : 1 << (31 - __builtin_clz(x));
+    }
+};
+
+/**
+ * Range add, range sum.
+ *
+ * Adding x to a[l, r) changes the prefix sum of the first i elements by
+ * x * (i - l) for l <= i < r and by x * (r - l) after. Both are linear in
+ * i, so prefix sums are kept as B1.sum(i) * i - B2.sum(i) with x added to
+ * B1 at l and removed at r, and x * l added to B2 at l and x * r removed
+ * at r.
+ *
+ * Time complexity: O(log n) per operation, O(n) to build
+ * Space complexity: O(n)
+ */
+template <class T>
+class RangeFenwick {
+public:
+
+    RangeFenwick(int n) : slope(n + 1), offset(n + 1) {}
+
+    /**
+     * Build from an array in O(n)
+     */
+    RangeFenwick(const std::vector<T> & a) : slope(a.size() + 1), offset(differences(a)) {}
+
+    int size() const
+    {
+        return slope.size() - 1;
+    }
+
+    /**
+     * Add x to a[l, r)
+     */
+    void add(int l, int r, T x)
+    {
+        slope.add(l, x);
+        slope.add(r, -x);
+        offset.add(l, x * (T) l);
+        offset.add(r, -x * (T) r);
+    }
+
+    /**
+     * Sum of the first i elements
+     */
+    T sum(int i) const
+    {
+        return slope.sum(i) * (T) i - offset.sum(i);
+    }
+
+    /**
+     * Sum of a[l, r)
+     */
+    T sum(int l, int r) const
+    {
+        return sum(r) - sum(l);
+    }
+
+    /**
+     * a[i]
+     */
+    T get(int i) const
+    {
+        return sum(i, i + 1);
+    }
+
+private:
+
+    FenwickTree<T> slope;
+    FenwickTree<T> offset;
+
+    /**
+     * With zero slope, sum(i) = -offset.sum(i), so offset starts as -a
+     */
+    static std::vector<T> differences(const std::vector<T> & a)
+    {
+        std::vector<T> d(a.size() + 1, T());
+        for (size_t i = 0; i < a.size(); ++i) {
+            d[i] = -a[i];
         }
+        return d;
     }
+};
+
+/**
+ * 2D Fenwick tree, point add, rectangle sum.
+ *
+ * A Fenwick tree of Fenwick trees stored in one flat array: the outer
+ * loop walks the rows, the inner loop the columns.
+ *
+ * Time complexity: O(log n * log m) per operation
+ * Space complexity: O(n * m)
+ */
+template <class T>
+class Fenwick2D {
+public:
+
+    Fenwick2D(int n, int m) : n(n), m(m), tree((size_t) (n + 1) * (m + 1)) {}
 
-    int query(int i)
+    /**
+     * a[x][y] += val
+     */
+    void add(int x, int y, T val)
     {
-        int res = 0;
-        for(; i > 0; i -= i & (-i)) {
-            res += this->arr[i];
+        for (int i = x + 1; i <= n; i += i & -i) {
+            T * row = &tree[(size_t) i * (m + 1)];
+            for (int j = y + 1; j <= m; j += j & -j) {
+                row[j] += val;
+            }
+        }
+    }
+
+    /**
+     * Sum of a[0, x) x [0, y)
+     */
+    T sum(int x, int y) const
+    {
+        T res = T();
+        for (int i = x; i > 0; i -= i & -i) {
+            const T * row = &tree[(size_t) i * (m + 1)];
+            for (int j = y; j > 0; j -= j & -j) {
+                res += row[j];
+            }
         }
 
         return res;
     }
 
-};
\ No newline at end of file
+    /**
+     * Sum of a[x1, x2) x [y1, y2)
+     */
+    T sum(int x1, int y1, int x2, int y2) const
+    {
+        return sum(x2, y2) - sum(x1, y2) - sum(x2, y1) + sum(x1, y1);
+    }
+
+private:
+
+    int n, m;
+
+    /** (n + 1) x (m + 1), row and column 0 unused */
+    std::vector<T> tree;
+};
+
+/**
+ * Lazy segment tree for range updates and range queries where the
+ * query operation need not be invertible.
+ * Reference: https://cp-algorithms.com/data_structures/segment_tree.html
+ *
+ * The operations are given by a policy M with:
+ * - using S: values, with associative S op(S, S) and identity S e()
+ * - using F: updates, with S apply(F, S), F compose(F f, F g) meaning
+ *   f after g, and identity F id()
+ * apply must distribute over op: apply(f, op(a, b)) = op(apply(f, a), apply(f, b)).
+ *
+ * The tree is iterative over a power-of-two number of leaves. Before
+ * touching a range, the pending updates on the paths to its two ends
+ * are pushed down; the range is then covered bottom-up as in a plain
+ * segment tree, and the ancestors of the ends are recomputed.
+ *
+ * Time complexity: O(log n) per operation, O(n) to build
+ * Space complexity: O(n)
+ */
+template <class M>
+class LazySegmentTree {
+public:
+    using S = typename M::S;
+    using F = typename M::F;
+
+    LazySegmentTree(int n) : LazySegmentTree(std::vector<S>(n, M::e())) {}
+
+    /**
+     * Build from an array in O(n)
+     */
+    LazySegmentTree(const std::vector<S> & a) : n(a.size())
+    {
+        log = 0;
+        while ((1 << log) < n) {
+            ++log;
+        }
+        half = 1 << log;
+
+        d.assign(2 * half, M::e());
+        lz.assign(half, M::id());
+
+        std::copy(a.begin(), a.end(), d.begin() + half);
+        for (int i = half - 1; i >= 1; --i) {
+            update(i);
+        }
+    }
+
+    int size() const
+    {
+        return n;
+    }
+
+    /**
+     * a[p] = x
+     */
+    void set(int p, S x)
+    {
+        p += half;
+        for (int i = log; i >= 1; --i) {
+            push(p >> i);
+        }
+        d[p] = x;
+        for (int i = 1; i <= log; ++i) {
+            update(p >> i);
+        }
+    }
+
+    /**
+     * a[p]
+     */
+    S get(int p)
+    {
+        p += half;
+        for (int i = log; i >= 1; --i) {
+            push(p >> i);
+        }
+        return d[p];
+    }
+
+    /**
+     * op over a[l, r)
+     */
+    S query(int l, int r)
+    {
+        if (l >= r) {
+            return M::e();
+        }
+
+        l += half;
+        r += half;
+        push_ends(l, r);
+
+        S left = M::e(), right = M::e();
+        for (; l < r; l >>= 1, r >>= 1) {
+            if (l & 1) {
+                left = M::op(left, d[l++]);
+            }
+            if (r & 1) {
+                right = M::op(d[--r], right);
+            }
+        }
+
+        return M::op(left, right);
+    }
+
+    /**
+     * op over all elements
+     */
+    S query_all() const
+    {
+        return d[1];
+    }
+
+    /**
+     * a[i] = apply(f, a[i]) for i in [l, r)
+     */
+    void apply(int l, int r, F f)
+    {
+        if (l >= r) {
+            return;
+        }
+
+        l += half;
+        r += half;
+        push_ends(l, r);
+
+        for (int a = l, b = r; a < b; a >>= 1, b >>= 1) {
+            if (a & 1) {
+                apply_node(a++, f);
+            }
+            if (b & 1) {
+                apply_node(--b, f);
+            }
+        }
+
+        for (int i = 1; i <= log; ++i) {
+            if (((l >> i) << i) != l) {
+                update(l >> i);
+            }
+            if (((r >> i) << i) != r) {
+                update((r - 1) >> i);
+            }
+        }
+    }
+
+private:
+
+    int n, log, half;
+
+    /** Values, d[1] is the root, leaves start at half */
+    std::vector<S> d;
+
+    /** Pending update of each inner node, already applied to d[i] */
+    std::vector<F> lz;
+
+    void update(int i)
+    {
+        d[i] = M::op(d[2 * i], d[2 * i + 1]);
+    }
+
+    void apply_node(int i, F f)
+    {
+        d[i] = M::apply(f, d[i]);
+        if (i < half) {
+            lz[i] = M::compose(f, lz[i]);
+        }
+    }
+
+    void push(int i)
+    {
+        apply_node(2 * i, lz[i]);
+        apply_node(2 * i + 1, lz[i]);
+        lz[i] = M::id();
+    }
+
+    /**
+     * Push pending updates down to the leaves at l and r - 1, except on
+     * the nodes that lie fully inside [l, r)
+     */
+    void push_ends(int l, int r)
+    {
+        for (int i = log; i >= 1; --i) {
+            if (((l >> i) << i) != l) {
+                push(l >> i);
+            }
+            if (((r >> i) << i) != r) {
+                push((r - 1) >> i);
+            }
+        }
+    }
+};
+
+/**
+ * Range add, range min
+ */
+template <class T>
+struct AddMin {
+    using S = T;
+    using F = T;
+
+    static S e() { return std::numeric_limits<T>::max(); }
+    static S op(S a, S b) { return std::min(a, b); }
+    static F id() { return T(); }
+    static S apply(F f, S x) { return x == e() ? x : x + f; }
+    static F compose(F f, F g) { return f + g; }
+};
+
+/**
+ * Range add, range max
+ */
+template <class T>
+struct AddMax {
+    using S = T;
+    using F = T;
+
+    static S e() { return std::numeric_limits<T>::lowest(); }
+    static S op(S a, S b) { return std::max(a, b); }
+    static F id() { return T(); }
+    static S apply(F f, S x) { return x == e() ? x : x + f; }
+    static F compose(F f, F g) { return f + g; }
+};
+
+/**
+ * Range add, range sum. Values carry the length of their segment, so
+ * build from {a[i], 1}. RangeFenwick does this with less memory when
+ * only sums are needed.
+ */
+template <class T>
+struct AddSum {
+    /** Sum and number of elements */
+    using S = std::pair<T, T>;
+    using F = T;
+
+    static S e() { return {T(), T()}; }
+    static S op(S a, S b) { return {a.first + b.first, a.second + b.second}; }
+    static F id() { return T(); }
+    static S apply(F f, S x) { return {x.first + f * x.second, x.second}; }
+    static F compose(F f, F g) { return f + g; }
+};
+
+/**
+ * Range assign, range sum. Values carry the length of their segment,
+ * so build from {a[i], 1}.
+ */
+template <class T>
+struct AssignSum {
+    /** Sum and number of elements */
+    using S = std::pair<T, T>;
+
+    /** Whether to assign and the value */
+    using F = std::pair<bool, T>;
+
+    static S e() { return {T(), T()}; }
+    static S op(S a, S b) { return {a.first + b.first, a.second + b.second}; }
+    static F id() { return {false, T()}; }
+    static S apply(F f, S x) { return f.first ? S{f.second * x.second, x.second} : x; }
+    static F compose(F f, F g) { return f.first ? f : g; }
+};
@@ -0,0 +1,123 @@
+/**
+ * @author: Oskar Arensmeier
+ * @date: 2025-05-16
+ */
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <barrier>
+#include <concepts>
+#include <algorithm>
+
+namespace Parallel {
+
+using namespace std;
+using ll = long long;
+
+/**
+ * Call f(i), or f(i, t) if f takes the index t of the running thread
+ */
+template <class F>
+void call(F & f, ll i, int t)
+{
+    if constexpr (invocable<F &, ll, int>) {
+        f(i, t);
+    } else {
+        f(i);
+    }
+}
+
+/**
+ * Run f for i in [0, count) across threads, handing out indexes
+ * through a shared counter
+ *
+ * f is called as f(i), or as f(i, t) with t in [0, threads) the index of
+ * the running thread (e.g. for per thread buffers). Runs inline when a
+ * single thread is enough.
+ */
+template <class F>
+void parallel_for(ll count, int threads, F f)
+{
+    threads = (int) min<ll>(max(1, threads), count);
+    if (threads <= 1) {
+        for (ll i = 0; i < count; ++i) {
+            call(f, i, 0);
+        }
+        return;
+    }
+
+    atomic<ll> next = 0;
+    auto worker = [&](int t) {
+        for (ll i = next++; i < count; i = next++) {
+            call(f, i, t);
+        }
+    };
+
+    vector<thread> pool;
+    for (int t = 1; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+
+    for (auto & th : pool) {
+        th.join();
+    }
+}
+
+/**
+ * Run steps 0 .. steps - 1 in order on one set of threads
+ *
+ * Step s runs f(s, i) for i in [0, count(s)), handing out indexes through
+ * a shared counter like parallel_for(). The threads are started once and
+ * a barrier separates consecutive steps, so short steps do not pay for
+ * spawning and joining threads each time.
+ */
+template <class C, class F>
+void parallel_steps(int steps, int threads, C count, F f)
+{
+    threads = max(1, threads);
+    if (threads == 1) {
+        for (int s = 0; s < steps; ++s) {
+            for (ll i = 0, size = count(s); i < size; ++i) {
+                f(s, i);
+            }
+        }
+        return;
+    }
+
+    int step = 0;
+    ll size = steps > 0 ? count(0) : 0;
+    atomic<ll> next = 0;
+
+    // Runs once every thread finished the step
+    auto advance = [&]() noexcept {
+        ++step;
+        next = 0;
+        size = step < steps ? count(step) : 0;
+    };
+
+    barrier sync(threads, advance);
+    auto worker = [&]() {
+        while (step < steps) {
+            for (ll i = next++; i < size; i = next++) {
+                f(step, i);
+            }
+            sync.arrive_and_wait();
+        }
+    };
+
+    vector<thread> pool;
+    for (int t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+
+    for (auto & th : pool) {
+        th.join();
+    }
+}
+
+}
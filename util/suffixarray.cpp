@@ -0,0 +1,329 @@
+/**
+ * @author: Oskar Arensmeier
+ * @date: 2025-05-25
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+
+/**
+ * Suffix array construction shared by the string labs
+ *
+ * sa_is(): SA-IS, induced sorting
+ * reference: G. Nong, S. Zhang, W. H. Chan, "Two Efficient Algorithms for
+ * Linear Time Suffix Array Construction", 2011
+ *
+ * 1. Classify every suffix as S (smaller than the next suffix) or L (larger).
+ *    An S suffix right after an L suffix is LMS (leftmost S).
+ * 2. Put the LMS suffixes at the ends of their first-character buckets and
+ *    induce: a left to right pass places L suffixes, a right to left pass
+ *    places S suffixes. This sorts the LMS substrings.
+ * 3. Name the LMS substrings by rank. If names repeat, sort the string of
+ *    names recursively (at most half the length).
+ * 4. Induce once more from the LMS suffixes in their true order.
+ *
+ * prefix_doubling(): the O(n log n) cyclic shift sort the labs used
+ * before, kept as the reference for benchmarks. It needs NUL-free text.
+ *
+ * lcp_array(): Kasai's LCP array from a suffix array.
+ *
+ * Index is the integer type of the result. 32-bit indices halve the memory
+ * and are used whenever they suffice (see fits_32()).
+ *
+ * Time complexity: O(n) for SA-IS, O(n log n) for prefix doubling
+ * Space complexity: O(n) Index values
+ */
+namespace SAIS {
+
+using namespace std;
+
+/**
+ * Suffix array of s[0..n), characters in [0, upper]
+ *
+ * @param s Characters
+ * @param n Length
+ * @param upper Largest character
+ * @return Start of the suffixes in sorted order
+ */
+template <class Index, class Char>
+vector<Index> sa_is(const Char * s, Index n, Index upper)
+{
+    if (n == 0) {
+        return {};
+    }
+    if (n == 1) {
+        return {0};
+    }
+    if (n == 2) {
+        return s[0] < s[1] ? vector<Index>{0, 1} : vector<Index>{1, 0};
+    }
+
+    vector<Index> sa(n);
+
+    // S or L type of each suffix, the last one is L
+    vector<bool> is_s(n, false);
+    for (Index i = n - 2; i >= 0; --i) {
+        is_s[i] = s[i] == s[i + 1] ? is_s[i + 1] : s[i] < s[i + 1];
+    }
+
+    // Bucket starts, start_l[c] for L suffixes
+    // beginning with c and start_s[c] for S ones
+    vector<Index> start_l(upper + 2, 0), start_s(upper + 2, 0);
+    for (Index i = 0; i < n; ++i) {
+        if (!is_s[i]) {
+            start_s[s[i]]++;
+        } else {
+            start_l[s[i] + 1]++;
+        }
+    }
+    for (Index c = 0; c <= upper; ++c) {
+        start_s[c] += start_l[c];
+        start_l[c + 1] += start_s[c];
+    }
+
+    vector<Index> bucket(upper + 2);
+    auto induce = [&](const vector<Index> & lms) {
+        fill(sa.begin(), sa.end(), -1);
+
+        copy(start_s.begin(), start_s.end(), bucket.begin());
+        for (Index d : lms) {
+            sa[bucket[s[d]]++] = d;
+        }
+
+        // L suffixes, left to right
+        copy(start_l.begin(), start_l.end(), bucket.begin());
+        sa[bucket[s[n - 1]]++] = n - 1;
+        for (Index i = 0; i < n; ++i) {
+            Index v = sa[i];
+            if (v >= 1 && !is_s[v - 1]) {
+                sa[bucket[s[v - 1]]++] = v - 1;
+            }
+        }
+
+        // S suffixes, right to left
+        copy(start_l.begin(), start_l.end(), bucket.begin());
+        for (Index i = n - 1; i >= 0; --i) {
+            Index v = sa[i];
+            if (v >= 1 && is_s[v - 1]) {
+                sa[--bucket[s[v - 1] + 1]] = v - 1;
+            }
+        }
+    };
+
+    // LMS positions, and their order among them
+    vector<Index> lms_id(n, -1);
+    vector<Index> lms;
+    for (Index i = 1; i < n; ++i) {
+        if (!is_s[i - 1] && is_s[i]) {
+            lms_id[i] = lms.size();
+            lms.push_back(i);
+        }
+    }
+    Index m = lms.size();
+
+    induce(lms);
+
+    if (m == 0) {
+        return sa;
+    }
+
+    // LMS suffixes sorted by their LMS substring
+    vector<Index> sorted;
+    sorted.reserve(m);
+    for (Index v : sa) {
+        if (lms_id[v] != -1) {
+            sorted.push_back(v);
+        }
+    }
+
+    // Name LMS substrings, equal substrings share a name
+    vector<Index> names(m);
+    Index name = 0;
+    names[lms_id[sorted[0]]] = 0;
+    for (Index i = 1; i < m; ++i) {
+        Index l = sorted[i - 1], r = sorted[i];
+        Index end_l = lms_id[l] + 1 < m ? lms[lms_id[l] + 1] : n;
+        Index end_r = lms_id[r] + 1 < m ? lms[lms_id[r] + 1] : n;
+
+        bool same = end_l - l == end_r - r;
+        if (same) {
+            for (; l < end_l && s[l] == s[r]; ++l, ++r) {}
+            same = l < n && r < n && s[l] == s[r];
+        }
+
+        if (!same) {
+            name++;
+        }
+        names[lms_id[sorted[i]]] = name;
+    }
+
+    lms_id = vector<Index>();
+
+    // True order of the LMS suffixes, recursing only if names repeat
+    if (name + 1 < m) {
+        vector<Index> order = sa_is<Index>(names.data(), m, name);
+        for (Index i = 0; i < m; ++i) {
+            sorted[i] = lms[order[i]];
+        }
+    }
+
+    induce(sorted);
+    return sa;
+}
+
+/**
+ * Suffix array of a byte string, SA-IS
+ *
+ * @param s String
+ * @return Start of the suffixes in sorted order
+ */
+template <class Index>
+vector<Index> suffix_array(const string & s)
+{
+    return sa_is<Index>((const unsigned char *) s.data(), (Index) s.size(), (Index) 255);
+}
+
+/**
+ * Suffix array of a byte string by sorting cyclic shifts of s + '\0'
+ * with prefix doubling, counting sort per round
+ *
+ * The appended '\0' is the sentinel that turns cyclic shifts into
+ * suffixes, so s itself must be NUL-free: a '\0' inside s ties with
+ * the sentinel and the order comes out wrong. suffix_array() has no
+ * such restriction.
+ *
+ * @param s String, without '\0'
+ * @return Start of the suffixes in sorted order
+ */
+template <class Index>
+vector<Index> prefix_doubling(const string & s)
+{
+    const Index ALPHABET_SIZE = 256;
+
+    Index n = s.size() + 1;
+    vector<Index> perm(n), cls(n), cnt(max(ALPHABET_SIZE, n), 0);
+
+    // Initial phase, sort by first char
+    for (Index i = 0; i + 1 < n; i++) {
+        cnt[(unsigned char) s[i]]++;
+    }
+    cnt[0]++;
+    for (Index i = 1; i < ALPHABET_SIZE; i++) {
+        cnt[i] += cnt[i-1];
+    }
+    for (Index i = n - 1; i >= 0; i--) {
+        unsigned char c = i + 1 < n ? s[i] : 0;
+        perm[--cnt[c]] = i;
+    }
+
+    cls[perm[0]] = 0;
+    Index cls_count = 1;
+    for (Index i = 1; i < n; i++) {
+        unsigned char a = perm[i] + 1 < n ? s[perm[i]] : 0;
+        unsigned char b = perm[i-1] + 1 < n ? s[perm[i-1]] : 0;
+        if (a != b) {
+            cls_count++;
+        }
+
+        cls[perm[i]] = cls_count - 1;
+    }
+
+    vector<Index> perm_tmp(n), cls_tmp(n);
+
+    // Double the length of the sorted shifts each round
+    for (Index h = 1; h < n; h *= 2) {
+        for (Index i = 0; i < n; i++) {
+            perm_tmp[i] = perm[i] - h;
+            if (perm_tmp[i] < 0) {
+                perm_tmp[i] += n;
+            }
+        }
+
+        fill(cnt.begin(), cnt.begin() + cls_count, 0);
+        for (Index i = 0; i < n; i++) {
+            cnt[cls[perm_tmp[i]]]++;
+        }
+        for (Index i = 1; i < cls_count; i++) {
+            cnt[i] += cnt[i-1];
+        }
+        for (Index i = n-1; i >= 0; i--) {
+            perm[--cnt[cls[perm_tmp[i]]]] = perm_tmp[i];
+        }
+
+        cls_tmp[perm[0]] = 0;
+        cls_count = 1;
+        for (Index i = 1; i < n; i++) {
+            Index a = perm[i] + h, b = perm[i-1] + h;
+            if (cls[perm[i]] != cls[perm[i-1]] || cls[a < n ? a : a - n] != cls[b < n ? b : b - n]) {
+                ++cls_count;
+            }
+
+            cls_tmp[perm[i]] = cls_count - 1;
+        }
+
+        cls.swap(cls_tmp);
+    }
+
+    // Drop the shift starting at '\0'
+    perm.erase(perm.begin());
+    return perm;
+}
+
+/**
+ * LCP array (Kasai), lcp[i] = longest common prefix of the
+ * suffixes sa[i - 1] and sa[i], lcp[0] = 0
+ *
+ * Going through suffixes in text order, the LCP with the sorted
+ * predecessor drops by at most one per step, so O(n) in total.
+ *
+ * @param s String
+ * @param sa Suffix array of s
+ * @return LCP array
+ */
+template <class Index>
+vector<Index> lcp_array(const string & s, const vector<Index> & sa)
+{
+    Index n = s.size();
+
+    // Inverse suffix array
+    vector<Index> rank(n);
+    for (Index i = 0; i < n; i++) {
+        rank[sa[i]] = i;
+    }
+
+    vector<Index> lcp(n, 0);
+    Index k = 0;
+    for (Index i = 0; i < n; i++) {
+        if (rank[i] == 0) {
+            k = 0;
+            continue;
+        }
+
+        Index j = sa[rank[i] - 1];
+        while (i + k < n && j + k < n && s[i + k] == s[j + k]) {
+            k++;
+        }
+
+        lcp[rank[i]] = k;
+        if (k > 0) {
+            k--;
+        }
+    }
+
+    return lcp;
+}
+
+/**
+ * True if suffix array indices of a string of length n fit in int32_t
+ */
+inline bool fits_32(size_t n)
+{
+    return n < (size_t) numeric_limits<int32_t>::max();
+}
+
+};
@@ -0,0 +1,446 @@
+/**
+ * @author: Oskar Arensmeier
+ * @date: 2025-05-25
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "suffixarray.cpp"
+
+namespace SAIS {
+
+using namespace std;
+
+/**
+ * Full text index: suffix array, inverse, LCP array and a range
+ * minimum structure over the LCP array, built once and saved to a
+ * binary file that is memory mapped on open, so query runs skip
+ * construction entirely.
+ *
+ * Pattern search is a binary search over the suffix array keeping the
+ * LCP of the pattern with both interval ends (Manber and Myers). The
+ * LCP between the middle suffix and an end comes from the range minimum
+ * structure, which decides most steps without looking at the text, so
+ * a search compares O(m + log n) characters.
+ *
+ * Range minimum: the minimum of every block of BLOCK LCP values, and a
+ * sparse table over the block minima. A query scans at most two partial
+ * blocks and reads two table entries.
+ *
+ * File layout (little endian, every section 8 byte aligned):
+ * header, text (n bytes), sa, rank, lcp (n Index each),
+ * table (levels * blocks Index)
+ *
+ * Time complexity: O(n) construction, O(m + log n) count,
+ * O(m + log n + occ) locate, O(BLOCK) lce
+ * Space complexity: O(n) Index values plus the text
+ */
+template <class Index>
+class TextIndex
+{
+public:
+    /**
+     * LCP values per block of the range minimum structure
+     */
+    static constexpr Index BLOCK = 32;
+
+    /**
+     * Build the index of a text
+     *
+     * @param text Text, any bytes
+     */
+    explicit TextIndex(const string & text)
+    {
+        text_store = text;
+        sa_store = suffix_array<Index>(text);
+        lcp_store = lcp_array(text, sa_store);
+
+        n = text.size();
+        rank_store.resize(n);
+        for (Index i = 0; i < n; ++i) {
+            rank_store[sa_store[i]] = i;
+        }
+
+        // Block minima, then doubling levels over them
+        blocks = (n + BLOCK - 1) / BLOCK;
+        levels = 0;
+        while (((Index) 1 << levels) <= blocks) {
+            levels++;
+        }
+
+        table_store.assign((size_t) levels * blocks, 0);
+        for (Index b = 0; b < blocks; ++b) {
+            Index low = lcp_store[b * BLOCK];
+            for (Index i = b * BLOCK; i < min(n, (b + 1) * BLOCK); ++i) {
+                low = min(low, lcp_store[i]);
+            }
+            table_store[b] = low;
+        }
+        for (Index k = 1; k < levels; ++k) {
+            Index * prev = &table_store[(size_t) (k - 1) * blocks];
+            Index * cur = &table_store[(size_t) k * blocks];
+            for (Index b = 0; b + ((Index) 1 << k) <= blocks; ++b) {
+                cur[b] = min(prev[b], prev[b + ((Index) 1 << (k - 1))]);
+            }
+        }
+
+        text_data = text_store.data();
+        sa = sa_store.data();
+        rank = rank_store.data();
+        lcp = lcp_store.data();
+        table = table_store.data();
+    }
+
+    /**
+     * Open a saved index, memory mapped
+     *
+     * @param path File written by save()
+     * @throws runtime_error if the file is missing or not an index with this Index type
+     */
+    static unique_ptr<TextIndex> open(const string & path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("Cannot open " + path);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(Header)) {
+            ::close(fd);
+            throw runtime_error("Not a text index: " + path);
+        }
+
+        void * map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            throw runtime_error("Cannot map " + path);
+        }
+
+        unique_ptr<TextIndex> index(new TextIndex());
+        index->map = map;
+        index->map_size = st.st_size;
+
+        const Header * header = (const Header *) map;
+        if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->width != sizeof(Index)) {
+            throw runtime_error("Not a text index with " + to_string(8 * sizeof(Index)) + "-bit indices: " + path);
+        }
+
+        index->n = header->n;
+        index->blocks = header->blocks;
+        index->levels = header->levels;
+
+        if (index->file_size() != (size_t) st.st_size) {
+            throw runtime_error("Truncated text index: " + path);
+        }
+
+        const char * base = (const char *) map;
+        size_t offset = align(sizeof(Header));
+        index->text_data = base + offset;
+        offset += align(index->n);
+        index->sa = (const Index *) (base + offset);
+        offset += align(index->n * sizeof(Index));
+        index->rank = (const Index *) (base + offset);
+        offset += align(index->n * sizeof(Index));
+        index->lcp = (const Index *) (base + offset);
+        offset += align(index->n * sizeof(Index));
+        index->table = (const Index *) (base + offset);
+
+        return index;
+    }
+
+    TextIndex(const TextIndex &) = delete;
+    TextIndex & operator=(const TextIndex &) = delete;
+
+    ~TextIndex()
+    {
+        if (map != nullptr) {
+            munmap(map, map_size);
+        }
+    }
+
+    /**
+     * Save the index
+     *
+     * @param path File to write
+     */
+    void save(const string & path) const
+    {
+        ofstream out(path, ios::binary | ios::trunc);
+        if (!out) {
+            throw runtime_error("Cannot write " + path);
+        }
+
+        Header header;
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.width = sizeof(Index);
+        header.n = n;
+        header.blocks = blocks;
+        header.levels = levels;
+
+        auto write = [&](const void * data, size_t bytes) {
+            static const char zeros[8] = {};
+            out.write((const char *) data, bytes);
+            out.write(zeros, align(bytes) - bytes);
+        };
+
+        write(&header, sizeof(header));
+        write(text_data, n);
+        write(sa, n * sizeof(Index));
+        write(rank, n * sizeof(Index));
+        write(lcp, n * sizeof(Index));
+        write(table, (size_t) levels * blocks * sizeof(Index));
+
+        if (!out) {
+            throw runtime_error("Cannot write " + path);
+        }
+    }
+
+    /**
+     * Text length
+     */
+    Index size() const
+    {
+        return n;
+    }
+
+    /**
+     * Number of occurrences of a pattern
+     */
+    Index count(const string & pattern) const
+    {
+        return search(pattern, true) - search(pattern, false);
+    }
+
+    /**
+     * Start of every occurrence of a pattern, in suffix order
+     */
+    vector<Index> locate(const string & pattern) const
+    {
+        return vector<Index>(sa + search(pattern, false), sa + search(pattern, true));
+    }
+
+    /**
+     * Longest common extension, the longest common prefix
+     * of the suffixes starting at i and j
+     */
+    Index lce(Index i, Index j) const
+    {
+        if (i < 0 || j < 0 || i >= n || j >= n) {
+            throw out_of_range("Position out of range");
+        }
+
+        if (i == j) {
+            return n - i;
+        }
+
+        Index a = rank[i], b = rank[j];
+        return range_min(min(a, b) + 1, max(a, b));
+    }
+
+    /**
+     * Longest substring occurring at least twice
+     *
+     * @return Length and start of one occurrence
+     */
+    pair<Index, Index> longest_repeat() const
+    {
+        pair<Index, Index> best = {0, 0};
+        for (Index i = 1; i < n; ++i) {
+            if (lcp[i] > best.first) {
+                best = {lcp[i], sa[i]};
+            }
+        }
+
+        return best;
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'S', 'A', 'L', 'C', 'P', 'I', 'D', 'X'};
+
+    /**
+     * File header
+     */
+    struct Header
+    {
+        char magic[8];
+        uint64_t width;
+        uint64_t n;
+        uint64_t blocks;
+        uint64_t levels;
+    };
+
+    /**
+     * Views, into the owned vectors or the mapped file
+     */
+    Index n = 0;
+    Index blocks = 0;
+    Index levels = 0;
+    const char * text_data = nullptr;
+    const Index * sa = nullptr;
+    const Index * rank = nullptr;
+    const Index * lcp = nullptr;
+    const Index * table = nullptr;
+
+    /**
+     * Storage of a built index
+     */
+    string text_store;
+    vector<Index> sa_store;
+    vector<Index> rank_store;
+    vector<Index> lcp_store;
+    vector<Index> table_store;
+
+    /**
+     * Mapping of an opened index
+     */
+    void * map = nullptr;
+    size_t map_size = 0;
+
+    TextIndex() = default;
+
+    static size_t align(size_t bytes)
+    {
+        return (bytes + 7) / 8 * 8;
+    }
+
+    size_t file_size() const
+    {
+        return align(sizeof(Header)) + align(n) + 3 * align(n * sizeof(Index))
+            + align((size_t) levels * blocks * sizeof(Index));
+    }
+
+    /**
+     * Minimum of lcp[lo..hi], lo <= hi
+     */
+    Index range_min(Index lo, Index hi) const
+    {
+        Index bl = lo / BLOCK, bh = hi / BLOCK;
+        Index low = lcp[lo];
+
+        if (bl == bh) {
+            for (Index i = lo; i <= hi; ++i) {
+                low = min(low, lcp[i]);
+            }
+            return low;
+        }
+
+        for (Index i = lo; i < (bl + 1) * BLOCK; ++i) {
+            low = min(low, lcp[i]);
+        }
+        for (Index i = bh * BLOCK; i <= hi; ++i) {
+            low = min(low, lcp[i]);
+        }
+
+        // Whole blocks in between, two overlapping table ranges
+        if (bl + 1 < bh) {
+            Index first = bl + 1, count = bh - first;
+            Index k = 63 - __builtin_clzll(count);
+            const Index * level = table + (size_t) k * blocks;
+            low = min({low, level[first], level[bh - ((Index) 1 << k)]});
+        }
+
+        return low;
+    }
+
+    /**
+     * First suffix array position whose suffix is >= pattern, or with
+     * upper, the first one after all suffixes starting with pattern
+     */
+    Index search(const string & pattern, bool upper) const
+    {
+        Index m = pattern.size();
+
+        // suffix(L) < target <= suffix(R), l and r the LCP
+        // of the pattern with them (0 at the virtual ends)
+        Index L = -1, R = n, l = 0, r = 0;
+
+        while (R - L > 1) {
+            Index M = L + (R - L) / 2;
+
+            // Decide by the LCP of M with the end sharing more with the pattern
+            Index k;
+            if (l >= r) {
+                Index x = L >= 0 ? range_min(L + 1, M) : 0;
+                if (L >= 0 && x > l) {
+                    L = M;
+                    continue;
+                }
+                if (L >= 0 && x < l) {
+                    R = M;
+                    r = x;
+                    continue;
+                }
+                k = l;
+            } else {
+                Index x = R < n ? range_min(M + 1, R) : 0;
+                if (R < n && x > r) {
+                    R = M;
+                    continue;
+                }
+                if (R < n && x < r) {
+                    L = M;
+                    l = x;
+                    continue;
+                }
+                k = r;
+            }
+
+            // Compare the text from k on
+            Index pos = sa[M];
+            while (k < m && pos + k < n && text_data[pos + k] == pattern[k]) {
+                k++;
+            }
+
+            bool less;
+            if (k == m) {
+                less = upper;
+            } else if (pos + k == n) {
+                less = true;
+            } else {
+                less = (unsigned char) text_data[pos + k] < (unsigned char) pattern[k];
+            }
+
+            if (less) {
+                L = M;
+                l = k;
+            } else {
+                R = M;
+                r = k;
+            }
+        }
+
+        return R;
+    }
+};
+
+/**
+ * Index width stored in a saved index, 4 or 8 bytes, 0 if unreadable
+ */
+inline size_t stored_width(const string & path)
+{
+    ifstream in(path, ios::binary);
+    char magic[8];
+    uint64_t width = 0;
+    in.read(magic, sizeof(magic));
+    in.read((char *) &width, sizeof(width));
+
+    if (!in || memcmp(magic, "SALCPIDX", sizeof(magic)) != 0) {
+        return 0;
+    }
+
+    return width;
+}
+
+};
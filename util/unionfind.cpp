@@ -0,0 +1,320 @@
+/**
+ * @author: Oskar Arensmeier
+ * @date: 2025-05-02
+ */
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+#include "parallel.cpp"
+
+namespace DSU {
+
+using namespace std;
+using ll = long long;
+
+/**
+ * Sequential union-find with union by rank and path splitting
+ *
+ * find() points every element on the path to its grandparent. This keeps
+ * the amortized bound of full path compression in a single pass without
+ * recursion, so long chains cannot overflow the stack.
+ *
+ * Complexity:
+ * O(α(n)) amortized per operation. Space: O(n)
+ */
+class UnionFind {
+private:
+    vector<int> parent;
+    vector<int> rank;
+
+public:
+    UnionFind(int n) : parent(n), rank(n, 0)
+    {
+        for (int i = 0; i < n; i++) {
+            parent[i] = i;
+        }
+    }
+
+    /**
+     * Find set representative for element x
+     * @param x element
+     * @return set representative
+     */
+    int find(int x)
+    {
+        while (parent[x] != x) {
+            int p = parent[x];
+            parent[x] = parent[p];
+            x = p;
+        }
+
+        return x;
+    }
+
+    /**
+     * Join (union) two sets
+     * @param x first set
+     * @param y second set
+     */
+    void join(int x, int y)
+    {
+        int rx = find(x);
+        int ry = find(y);
+
+        if (rx == ry) {
+            return;
+        }
+
+        if (rank[rx] < rank[ry]) {
+            swap(rx, ry);
+        }
+
+        parent[ry] = rx;
+
+        if (rank[rx] == rank[ry]) {
+            rank[rx]++;
+        }
+    }
+
+    /**
+     * Check if two sets are the same
+     * @param x first set
+     * @param y second set
+     */
+    bool same(int x, int y)
+    {
+        return find(x) == find(y);
+    }
+};
+
+/**
+ * Lock-free union-find, safe for concurrent join() and same() calls
+ * from any number of threads.
+ *
+ * reference: Jayanti, Tarjan, "A Randomized Concurrent Algorithm for
+ * Disjoint Set Union" (PODC 2016)
+ *
+ * Each element stores its parent in an atomic word, roots point to
+ * themselves. A root only ever changes by a compare-and-swap from itself
+ * to another root, so a join that loses a race sees its CAS fail and
+ * retries from the new roots.
+ *
+ * Linking is by index: of two roots the one with the smaller priority
+ * goes under the other. The priority is a fixed bijective hash of the
+ * index, which behaves like the random total order of the reference, so
+ * trees stay O(log n) deep without storing ranks that would need a
+ * second word in the CAS.
+ *
+ * find() does path splitting: every visited element is CASed to point to
+ * its grandparent. The CAS may fail when another thread got there first,
+ * which is harmless, both results point further up the same tree. The
+ * walk is iterative, so long chains cannot overflow the stack.
+ *
+ * Complexity:
+ * O(log n) expected per operation in the worst case, close to O(1)
+ * amortized in practice. Space: O(n)
+ */
+class ConcurrentUnionFind {
+public:
+
+    /**
+     * @param n Number of elements
+     * @throws length_error if n does not fit in 32 bits
+     */
+    ConcurrentUnionFind(ll n) : parent(checked_size(n))
+    {
+        for (ll i = 0; i < n; ++i) {
+            parent[i].store(i, memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Number of elements
+     */
+    ll size() const
+    {
+        return parent.size();
+    }
+
+    /**
+     * Find set representative for element x. Only stable while no
+     * join() runs concurrently.
+     */
+    uint32_t find(uint32_t x)
+    {
+        while (true) {
+            uint32_t p = parent[x].load(memory_order_relaxed);
+            uint32_t g = parent[p].load(memory_order_relaxed);
+
+            if (p == g) {
+                return p;
+            }
+
+            parent[x].compare_exchange_weak(p, g, memory_order_relaxed);
+            x = p;
+        }
+    }
+
+    /**
+     * Join (union) the sets of x and y
+     *
+     * @return true if they were different sets
+     */
+    bool join(uint32_t x, uint32_t y)
+    {
+        while (true) {
+            x = find(x);
+            y = find(y);
+
+            if (x == y) {
+                return false;
+            }
+
+            if (priority(x) > priority(y)) {
+                swap(x, y);
+            }
+
+            // Fails if x stopped being a root meanwhile
+            uint32_t expected = x;
+            if (parent[x].compare_exchange_strong(expected, y)) {
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Check if x and y are in the same set. Linearizable: if x and y
+     * have different roots, one of them is checked to still be a root.
+     */
+    bool same(uint32_t x, uint32_t y)
+    {
+        while (true) {
+            x = find(x);
+            y = find(y);
+
+            if (x == y) {
+                return true;
+            }
+
+            if (parent[x].load() == x) {
+                return false;
+            }
+        }
+    }
+
+private:
+
+    /** Parent of each element, roots point to themselves */
+    vector<atomic<uint32_t>> parent;
+
+    static ll checked_size(ll n)
+    {
+        if (n < 0 || n > (ll) UINT32_MAX) {
+            throw length_error("ConcurrentUnionFind supports at most 2^32 - 1 elements");
+        }
+        return n;
+    }
+
+    /**
+     * Bijective mix of the index (murmur3 finalizer)
+     */
+    static uint32_t priority(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x85ebca6bu;
+        x ^= x >> 13;
+        x *= 0xc2b2ae35u;
+        x ^= x >> 16;
+        return x;
+    }
+};
+
+/**
+ * Result of connected_components()
+ */
+struct Components {
+
+    /** Number of components */
+    ll count = 0;
+
+    /** Component of each node, in [0, count), numbered by smallest node */
+    vector<uint32_t> label;
+
+    /** Number of nodes in each component */
+    vector<ll> size;
+};
+
+/**
+ * Connected components of an edge list, ingested in parallel.
+ *
+ * The edges are cut into blocks of BLOCK edges that threads claim from a
+ * shared counter and join into one ConcurrentUnionFind, so no thread
+ * waits on another and the edge list is read exactly once. Labels and
+ * sizes are then computed in two passes over the nodes: finding every
+ * root in parallel, then numbering roots in node order.
+ *
+ * Complexity:
+ * O((n + m) / threads) expected time, close to linear work in practice.
+ * O(n) space besides the edges.
+ *
+ * @param n Number of nodes
+ * @param edges Edges as pairs of nodes in [0, n)
+ * @param m Number of edges
+ * @param threads Number of threads
+ */
+inline Components connected_components(ll n, const pair<uint32_t, uint32_t> * edges, ll m,
+                                       int threads = thread::hardware_concurrency())
+{
+    const ll BLOCK = 1 << 16;
+
+    ConcurrentUnionFind uf(n);
+
+    Parallel::parallel_for((m + BLOCK - 1) / BLOCK, threads, [&](ll b) {
+        ll end = min(m, (b + 1) * BLOCK);
+        for (ll i = b * BLOCK; i < end; ++i) {
+            uf.join(edges[i].first, edges[i].second);
+        }
+    });
+
+    Components res;
+    res.label.resize(n);
+
+    Parallel::parallel_for((n + BLOCK - 1) / BLOCK, threads, [&](ll b) {
+        ll end = min(n, (b + 1) * BLOCK);
+        for (ll i = b * BLOCK; i < end; ++i) {
+            res.label[i] = uf.find(i);
+        }
+    });
+
+    // Number components in order of their smallest node
+    vector<uint32_t> id(n, UINT32_MAX);
+    for (ll i = 0; i < n; ++i) {
+        uint32_t & c = id[res.label[i]];
+        if (c == UINT32_MAX) {
+            c = res.count++;
+            res.size.push_back(0);
+        }
+        res.label[i] = c;
+        ++res.size[c];
+    }
+
+    return res;
+}
+
+/**
+ * Connected components of an edge list, see above
+ */
+inline Components connected_components(ll n, const vector<pair<uint32_t, uint32_t>> & edges,
+                                       int threads = thread::hardware_concurrency())
+{
+    return connected_components(n, edges.data(), edges.size(), threads);
+}
+
+}